@@ -1,4 +1,5 @@
 #include "command.hpp"
+#include "command_processor.hpp"
 #include <memory>
 
 enum class Waveshape
@@ -8,14 +9,12 @@ enum class Waveshape
     Pulse
 };
 
-struct CommandDemo : public MusicLib::Command
+/**
+ * @brief The data of a command, without the Command interface, so that it
+ * can be stored in a compiled song file and mapped back as is.
+ */
+struct EventDemo
 {
-public:
-    std::unique_ptr<Command> clone() const override
-    {
-        return std::make_unique<CommandDemo>(*this);
-    } 
-
 public:
     enum class Type
     {
@@ -58,4 +57,35 @@ public:
             Waveshape shape;
         } wave;
     };
-};
\ No newline at end of file
+};
+
+struct CommandDemo : public MusicLib::Command, public EventDemo
+{
+public:
+    CommandDemo() = default;
+
+    explicit CommandDemo(const EventDemo& event)
+    : EventDemo{event}
+    {}
+
+    std::unique_ptr<Command> clone() const override
+    {
+        return std::make_unique<CommandDemo>(*this);
+    } 
+
+    Command* clone_into(MusicLib::Arena& arena) const override
+    {
+        return arena.create<CommandDemo>(*this);
+    }
+
+    MusicLib::CommandTarget targets() const
+    {
+        // Notes also set the time until the next step.
+        if (type == Type::Note)
+        {
+            return MusicLib::CommandTarget::TimeManager | MusicLib::CommandTarget::Device;
+        }
+
+        return MusicLib::CommandTarget::Device;
+    }
+};
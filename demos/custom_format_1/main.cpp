@@ -1,186 +1,165 @@
 #include "command_demo.hpp"
 
+#include "audio_manager_offline.hpp"
 #include "audio_manager_portaudio.hpp"
+#include "command_processor.hpp"
 #include "command_stream.hpp"
+#include "control_queue.hpp"
 #include "instrument.hpp"
 #include "instrument_manager.hpp"
+#include "mapped_file.hpp"
 #include "sequencer.hpp"
+#include "song_file.hpp"
+#include "song_parser.hpp"
 #include "time_manager.hpp"
-#include "pitch.hpp"
+#include "tuning.hpp"
+#include "realtime_check.hpp"
 #include "voice.hpp"
 #include "envelope.hpp"
 
 #include <iostream>
-#include <fstream>
+#include <memory>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <optional>
+#include <vector>
 
 #include <portaudio.h>
 
 #define SAMPLE_RATE 44100
 #define BUFFER_SIZE 512
 #define NUM_INSTRUMENTS_MAX 32
+#define SONG_FORMAT 0x31304643 // "CF01"
 
 using OscDemo = MusicLib::OscillatorSwitch<MusicLib::OscillatorBasic>;
-using VoiceDemo = MusicLib::VoiceOsc<OscDemo, MusicLib::EnvelopeADSR>;
+using VoiceDemo = MusicLib::VoiceStatic<OscDemo, MusicLib::EnvelopeADSR>;
 using InsDemo = MusicLib::Instrument<VoiceDemo, MusicLib::OutputStereo>;
 using InsMgrDemo = MusicLib::InstrumentManager<InsDemo>;
+using CmdStreamDemo = MusicLib::CommandStreamFlat<CommandDemo>;
+using CmdStreamMappedDemo = MusicLib::CommandStreamMapped<CommandDemo, EventDemo>;
 
 /**
- * @brief 
+ * @brief Make a command out of a line of a song file. Lines with unknown
+ * commands are ignored, and invalid ones are reported to the parser.
  * 
- * @param tokens a string that contains a command identifier followed by
- *     arguments.
+ * @param line a command identifier followed by arguments.
  *     Note command: N [instrument] [duration] [pitch]
  *     Volume command: V [instrument] [volume]
  * @return CommandDemo 
  */
-std::optional<CommandDemo> make_command(std::vector<std::string> tokens, unsigned int& ins_num)
+std::optional<CommandDemo> make_command(const MusicLib::SongLine& line, MusicLib::SongParser& parser,
+    unsigned int& ins_num)
 {
     CommandDemo cmd;
+    unsigned int shape = 0;
+    bool is_valid;
 
-    try
+    switch (line[0][0])
     {
-        switch (tokens[0][0])
-        {
-        case 'N':
-            cmd.type = CommandDemo::Type::Note;
-            cmd.note.ins = std::stoi(tokens[1]);
-            cmd.note.duration = std::stof(tokens[2]);
-            cmd.note.pitch = std::stoi(tokens[3]);
-
-            ins_num = cmd.note.ins;
-            break;
-            
-        case 'P':
-            cmd.type = CommandDemo::Type::Pan;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[2]);
-
-            ins_num = cmd.param_float.ins;
-            break;
+    case 'N':
+        cmd.type = CommandDemo::Type::Note;
+        is_valid = line.get(1, cmd.note.ins) && line.get(2, cmd.note.duration) && line.get(3, cmd.note.pitch);
+        break;
+        
+    case 'P':
+        cmd.type = CommandDemo::Type::Pan;
+        is_valid = line.get(1, cmd.param_float.ins) && line.get(2, cmd.param_float.amount);
+        break;
     
-        case 'V':
-            cmd.type = CommandDemo::Type::Vol;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[2]);
-
-            ins_num = cmd.param_float.ins;
-            break;
+    case 'V':
+        cmd.type = CommandDemo::Type::Vol;
+        is_valid = line.get(1, cmd.param_float.ins) && line.get(2, cmd.param_float.amount);
+        break;
     
-        case 'W':
-            cmd.type = CommandDemo::Type::Waveshape;
-            cmd.wave.ins = std::stoi(tokens[1]);
-            cmd.wave.shape = (Waveshape) std::stoi(tokens[2]);
-
-            ins_num = cmd.wave.ins;
-            break;
-
-        case 'A':
-            cmd.type = CommandDemo::Type::Attack;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[1]);
-
-            ins_num = cmd.param_float.ins;
-            break;
+    case 'W':
+        cmd.type = CommandDemo::Type::Waveshape;
+        is_valid = line.get(1, cmd.wave.ins) && line.get(2, shape);
+        cmd.wave.shape = (Waveshape) shape;
+        break;
+
+    case 'A':
+        cmd.type = CommandDemo::Type::Attack;
+        is_valid = line.get(1, cmd.param_time.ins) && line.get(2, cmd.param_time.duration);
+        break;
         
-        case 'D':
-            cmd.type = CommandDemo::Type::Decay;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[1]);
-
-            ins_num = cmd.param_float.ins;
-            break;
-
-        case 'S':
-            cmd.type = CommandDemo::Type::Sustain;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[1]);
-
-            ins_num = cmd.param_float.ins;
-            break;
-
-        case 'R':
-            cmd.type = CommandDemo::Type::Release;
-            cmd.param_float.ins = std::stoi(tokens[1]);
-            cmd.param_float.amount = std::stof(tokens[1]);
-            
-            ins_num = cmd.param_float.ins;
-            break;
+    case 'D':
+        cmd.type = CommandDemo::Type::Decay;
+        is_valid = line.get(1, cmd.param_time.ins) && line.get(2, cmd.param_time.duration);
+        break;
+
+    case 'S':
+        cmd.type = CommandDemo::Type::Sustain;
+        is_valid = line.get(1, cmd.param_float.ins) && line.get(2, cmd.param_float.amount);
+        break;
+
+    case 'R':
+        cmd.type = CommandDemo::Type::Release;
+        is_valid = line.get(1, cmd.param_time.ins) && line.get(2, cmd.param_time.duration);
+        break;
     
-        default:
-            return std::nullopt;
-        }
+    default:
+        return std::nullopt;
+    }
 
-        if (ins_num >= NUM_INSTRUMENTS_MAX)
-        {
-            // This instrument number is too large. This command will be
-            // ignored.
-            ins_num = 0;
-            return std::nullopt;
-        }
+    if (!is_valid)
+    {
+        parser.error(line, "invalid arguments");
+        return std::nullopt;
     }
-    catch(const std::exception& e)
+
+    // Every command starts with its instrument number.
+    if (cmd.note.ins >= NUM_INSTRUMENTS_MAX)
     {
+        parser.error(line, "instrument number too large");
         return std::nullopt;
     }
-    
 
+    ins_num = cmd.note.ins;
     return cmd;
 }
 
-MusicLib::CommandStreamBasic parse_file(std::string song_filename, unsigned int& max_ins_num)
+/**
+ * @brief Parse a song file straight into a command stream, reporting invalid
+ * lines. Throws std::runtime_error if the file can't be read.
+ */
+void parse_file(const std::string& song_filename, CmdStreamDemo& cmd_stream, unsigned int& max_ins_num)
 {
-    auto cmd_stream = MusicLib::CommandStreamBasic{true};
+    MusicLib::MappedFile file{song_filename, true};
+    std::string_view text = file.text();
+
+    // There's at most a command per line, so the stream never grows.
+    cmd_stream.reserve(MusicLib::SongParser::count_lines(text));
 
-    std::ifstream file(song_filename);
-    std::string line;
-    std::string token;
-    std::vector<std::string> tokens;
+    MusicLib::SongParser parser{text};
+    MusicLib::SongLine line;
     unsigned int ins_num = 0;
 
-    if (file.is_open())
+    while (parser.next(line))
     {
-        while (std::getline(file, line))
+        auto cmd = make_command(line, parser, ins_num);
+
+        if (cmd.has_value())
         {
-            std::stringstream ss(line);
+            cmd_stream.add(cmd.value());
 
-            while (std::getline(ss, token, ' '))
-            {
-                tokens.push_back(token);
-            }
-            if (tokens.size() > 0)
+            // Check if number of instruments need to get increased.
+            if (ins_num > max_ins_num)
             {
-                auto cmd = make_command(tokens, ins_num);
-                
-                if (cmd.has_value())
-                {
-                    cmd_stream.add(cmd.value());
-
-                    // Check if number of instruments need to get increased.
-                    if (ins_num > max_ins_num)
-                    {
-                        max_ins_num = ins_num;
-                    }
-                }
-                tokens = {};
+                max_ins_num = ins_num;
             }
         }
-        file.close();
     }
-    else
+
+    for (const auto& error : parser.errors())
     {
-        std::cerr << "File not found." << std::endl;
+        std::cerr << song_filename << ":" << error.line << ": " << error.message << std::endl;
     }
 
-    // auto cmd_stream = MusicLib::CommandStreamBasic{commands, true};
-    return cmd_stream;
-}
-
-void handle_command_stream(CommandDemo& cmd [[maybe_unused]], MusicLib::CommandStreamBasic& cmd_stream  [[maybe_unused]])
-{
-
+    if (parser.error_count() > parser.errors().size())
+    {
+        std::cerr << song_filename << ": " << parser.error_count() - parser.errors().size()
+            << " more errors" << std::endl;
+    }
 }
 
 void handle_instrument_manager(CommandDemo& cmd, InsMgrDemo& ins_mgr)
@@ -190,7 +169,7 @@ void handle_instrument_manager(CommandDemo& cmd, InsMgrDemo& ins_mgr)
     switch (cmd.type)
     {
     case CommandDemo::Type::Note:
-        freq = MusicLib::freq_from_pitch[cmd.note.pitch];
+        freq = MusicLib::Tuning::current().freq(cmd.note.pitch);
         if (freq > 0)
         {
             ins_mgr
@@ -280,6 +259,43 @@ void handle_time_manager(CommandDemo& cmd, MusicLib::TimeManagerEventBased& time
     }
 }
 
+/**
+ * @brief Compile a song file into the binary format, which can be played
+ * without parsing.
+ */
+int compile(std::string song_filename, std::string output_filename)
+{
+    unsigned int max_ins_num = 0;
+    CmdStreamDemo cmd_stream;
+
+    try
+    {
+        parse_file(song_filename, cmd_stream, max_ins_num);
+
+        std::vector<EventDemo> events(cmd_stream.commands().begin(), cmd_stream.commands().end());
+
+        std::vector<MusicLib::SongInstrument> instruments;
+        for (unsigned int i = 0; i <= max_ins_num; ++i)
+        {
+            instruments.push_back({i, 0, 1, .5});
+        }
+
+        MusicLib::SongFile::write<EventDemo>(output_filename, SONG_FORMAT, instruments, events);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Compiled " << cmd_stream.size() << " commands to " << output_filename << std::endl;
+    return 0;
+}
+
+// Any command stream type, since there's no command stream handler.
+using CmdProcessorDemo = MusicLib::CommandProcessorStatic<CommandDemo, MusicLib::CommandStream, InsMgrDemo,
+    MusicLib::TimeManagerEventBased, handle_time_manager, handle_instrument_manager>;
+
 int main(int argc, char *argv[])
 {
     if (argc <= 1)
@@ -289,13 +305,57 @@ int main(int argc, char *argv[])
     }
     std::string song_filename(argv[1]);
 
+    if (song_filename == "-c")
+    {
+        if (argc <= 3)
+        {
+            std::cout << "Please give a song file and an output file to compile it into." << std::endl;
+            return 0;
+        }
+
+        return compile(argv[2], argv[3]);
+    }
+
+    // When an output file is given, render the song into it instead of
+    // playing it.
+    bool offline = argc > 2;
+
+    // Compiled songs are mapped and played in place; others are parsed.
     unsigned int max_ins_num = 0; // Largest instrument number
-    MusicLib::CommandStreamBasic cmd_stream = parse_file(song_filename, max_ins_num);
+    std::optional<MusicLib::SongFile> song_file;
+    std::unique_ptr<MusicLib::CommandStream> cmd_stream_ptr;
 
-    MusicLib::CommandProcessorBasic cmd_processor;
-    cmd_processor.set_command_stream_handler<CommandDemo, MusicLib::CommandStreamBasic>(handle_command_stream);
-    cmd_processor.set_device_handler<CommandDemo, InsMgrDemo>(handle_instrument_manager);
-    cmd_processor.set_time_handler<CommandDemo, MusicLib::TimeManagerEventBased>(handle_time_manager);
+    try
+    {
+        if (MusicLib::SongFile::is_song_file(song_filename))
+        {
+            song_file.emplace(song_filename);
+            if (song_file->format() != SONG_FORMAT || song_file->instruments().empty()
+                || song_file->instruments().size() > NUM_INSTRUMENTS_MAX)
+            {
+                std::cerr << "Unsupported compiled song." << std::endl;
+                return 1;
+            }
+
+            max_ins_num = song_file->instruments().size() - 1;
+            cmd_stream_ptr = std::make_unique<CmdStreamMappedDemo>(song_file->events<EventDemo>(), !offline);
+        }
+        else
+        {
+            auto cmd_stream_flat = std::make_unique<CmdStreamDemo>(!offline);
+            parse_file(song_filename, *cmd_stream_flat, max_ins_num);
+            cmd_stream_ptr = std::move(cmd_stream_flat);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    MusicLib::CommandStream& cmd_stream = *cmd_stream_ptr;
+
+    CmdProcessorDemo cmd_processor;
 
     InsMgrDemo ins_mgr{};
     MusicLib::OscillatorBasic osc_triangle(MusicLib::osc_triangle);
@@ -323,8 +383,40 @@ int main(int argc, char *argv[])
     MusicLib::TimeManagerEventBased time_mgr;
     MusicLib::SequencerBasic seq{time_mgr, ins_mgr, cmd_stream, cmd_processor};
 
-    // Set audio manager.
-    MusicLib::PortAudioDataOut data{seq, ins_mgr, 1. / SAMPLE_RATE};
+    if (offline)
+    {
+        std::string output_filename(argv[2]);
+        MusicLib::AudioManagerOffline audio_manager{SAMPLE_RATE, seq, ins_mgr, cmd_stream};
+        audio_manager.output_file(output_filename);
+
+        time_mgr.playing(true);
+        try
+        {
+            audio_manager.start();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        std::cout << "Rendered " << audio_manager.frames_rendered() / (float) SAMPLE_RATE
+            << " s to " << output_filename << " in " << audio_manager.render_time()
+            << " s (" << audio_manager.realtime_factor() << "x realtime)" << std::endl;
+
+        // Only counted when MusicLib is built with MUSICLIB_REALTIME_CHECK.
+        if (MusicLib::RealtimeCheck::count() > 0)
+        {
+            MusicLib::RealtimeCheck::report(std::cerr);
+        }
+
+        return 0;
+    }
+
+    // Set audio manager. The transport is controlled through a queue, since
+    // the sequencer is owned by the audio thread once the stream starts.
+    MusicLib::ControlQueueBasic<CommandDemo> control;
+    MusicLib::PortAudioDataOut data{seq, ins_mgr, 1. / SAMPLE_RATE, &control};
     MusicLib::AudioManagerPortAudio audio_manager{SAMPLE_RATE, BUFFER_SIZE, data};
 
     char input;
@@ -335,8 +427,19 @@ int main(int argc, char *argv[])
 
     do
     {
-        time_mgr.playing(playing);
-        std::cin.get(input);
+        if (playing)
+        {
+            control.play();
+        }
+        else
+        {
+            control.pause();
+        }
+        // Skips whitespace, so that only commands are dispatched.
+        if (!(std::cin >> input))
+        {
+            break;
+        }
 
         switch(input)
         {
@@ -346,8 +449,7 @@ int main(int argc, char *argv[])
 
         case 's':
             playing = false;
-            time_mgr.playing(false);
-            seq.reset();
+            control.stop();
             break;            
         }
     } while(playing);
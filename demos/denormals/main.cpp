@@ -0,0 +1,154 @@
+#include "denormals.hpp"
+#include "device.hpp"
+#include "envelope.hpp"
+#include "instrument.hpp"
+#include "instrument_manager.hpp"
+#include "osc.hpp"
+#include "util.hpp"
+#include "voice.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#define SAMPLE_RATE 44100
+#define BUFFER_SIZE 512
+#define NUM_INSTRUMENTS 8
+
+using VoiceBench = MusicLib::VoiceStatic<MusicLib::OscillatorBasic, MusicLib::EnvelopeADSR>;
+using InsBench = MusicLib::Instrument<VoiceBench, MusicLib::OutputStereo>;
+using InsMgrBench = MusicLib::InstrumentManager<InsBench>;
+
+/**
+ * @brief A one-pole lowpass filter. Once its input goes silent, its state
+ * decays exponentially into the subnormal range, and then gets stuck on the
+ * smallest subnormal, since each step is too small to round away from it.
+ */
+class Lowpass : public MusicLib::Device<MusicLib::InputStereo, MusicLib::OutputStereo>
+{
+public:
+    explicit Lowpass(float coef)
+    : m_coef{coef}
+    , m_left{0}
+    , m_right{0}
+    {}
+
+    std::unique_ptr<Device> clone() const override
+    {
+        return std::make_unique<Lowpass>(*this);
+    }
+
+    void vol(float vol [[maybe_unused]]) override {}
+    float vol() const override { return 1; }
+    void pan(float pan [[maybe_unused]]) override {}
+    float pan() const override { return .5; }
+
+    void process(float sample_duration [[maybe_unused]], float in_left, float in_right,
+        float& out_left, float& out_right) override
+    {
+        m_left += m_coef * (in_left - m_left);
+        m_right += m_coef * (in_right - m_right);
+        out_left = m_left;
+        out_right = m_right;
+    }
+
+private:
+    float m_coef;
+    float m_left;
+    float m_right;
+};
+
+struct Window
+{
+    // Render time, in nanoseconds per frame.
+    double time;
+
+    // Peak output level.
+    float peak;
+};
+
+/**
+ * @brief Play a one second chord through the filter, then let it ring out,
+ * with each callback-sized block rendered in the given denormal mode.
+ * Returns the render time and peak level of every half second of audio.
+ */
+std::vector<Window> render(MusicLib::DenormalMode mode, float duration)
+{
+    VoiceBench voice{MusicLib::OscillatorBasic{MusicLib::osc_saw}, MusicLib::EnvelopeADSR{.01, .1, .7, .3}};
+    InsBench ins{voice, 1.f / NUM_INSTRUMENTS};
+    InsMgrBench ins_mgr{};
+    Lowpass lowpass{.001};
+
+    for (unsigned int i = 0; i < NUM_INSTRUMENTS; ++i)
+    {
+        ins_mgr.clone_instrument(ins);
+        ins_mgr.instrument(i).note_on(220.f * (i + 2) / 2);
+    }
+
+    float dry_left[BUFFER_SIZE], dry_right[BUFFER_SIZE];
+    float left[BUFFER_SIZE], right[BUFFER_SIZE];
+    const size_t window = SAMPLE_RATE / 2;
+    const size_t frames = duration * SAMPLE_RATE;
+
+    std::vector<Window> windows;
+    double elapsed = 0;
+    float peak = 0;
+
+    for (size_t offset = 0; offset < frames; offset += BUFFER_SIZE)
+    {
+        if (offset <= SAMPLE_RATE && offset + BUFFER_SIZE > SAMPLE_RATE)
+        {
+            for (unsigned int i = 0; i < NUM_INSTRUMENTS; ++i)
+            {
+                ins_mgr.instrument(i).note_off();
+            }
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        {
+            // What the audio manager does around each callback.
+            MusicLib::DenormalGuard denormal_guard{mode};
+            ins_mgr.process_block(1.f / SAMPLE_RATE, dry_left, dry_right, BUFFER_SIZE);
+            lowpass.process_block(1.f / SAMPLE_RATE, dry_left, dry_right, left, right, BUFFER_SIZE);
+        }
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        for (size_t i = 0; i < BUFFER_SIZE; ++i)
+        {
+            peak = std::max({peak, std::abs(left[i]), std::abs(right[i])});
+        }
+
+        if ((offset + BUFFER_SIZE) / window != offset / window)
+        {
+            windows.push_back({elapsed * 1e9 / window, peak});
+            elapsed = 0;
+            peak = 0;
+        }
+    }
+
+    return windows;
+}
+
+int main()
+{
+    const float duration = 8;
+
+    // Render once to warm up.
+    render(MusicLib::DenormalMode::Flush, 1);
+
+    auto keep = render(MusicLib::DenormalMode::Keep, duration);
+    auto flush = render(MusicLib::DenormalMode::Flush, duration);
+
+    std::printf("Render time (ns/frame). The chord is released at 1 s, and the\n"
+        "filter's state turns subnormal a couple of seconds later.\n\n");
+    std::printf("  time     keep    flush  peak level\n");
+    for (size_t i = 0; i < std::min(keep.size(), flush.size()); ++i)
+    {
+        std::printf("%5.1f s %8.2f %8.2f  %g\n", (i + 1) * .5, keep[i].time, flush[i].time, keep[i].peak);
+    }
+
+    return 0;
+}
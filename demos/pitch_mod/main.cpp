@@ -0,0 +1,91 @@
+#include "pitch_mod.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#define SAMPLE_RATE 44100
+#define NUM_SAMPLES (1 << 22)
+#define BLOCK_SIZE 256
+
+/**
+ * @brief The way a glide and vibrato would be rendered without PitchMod: the
+ * same pitch computation, and std::pow per sample.
+ */
+float render_pow(float* phase_increments, float from, float to, float glide, float depth, float rate)
+{
+    const float dt = 1.f / SAMPLE_RATE;
+    float pitch = from;
+    float vibrato_phase = 0;
+    float sink = 0;
+
+    for (size_t offset = 0; offset < NUM_SAMPLES; offset += BLOCK_SIZE)
+    {
+        for (size_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            pitch = pitch < to ? std::min(pitch + (to - from) / glide * dt, to) : to;
+            vibrato_phase += rate * dt;
+            vibrato_phase -= (int) vibrato_phase;
+
+            float lfo = 1 - 4 * std::abs(vibrato_phase + .25f - (int) (vibrato_phase + .25f) - .5f);
+            phase_increments[i] = dt * 440 * std::pow(2.f, (pitch + depth * lfo) / 12);
+        }
+
+        sink += phase_increments[BLOCK_SIZE - 1];
+    }
+
+    return sink;
+}
+
+float render_pitch_mod(float* phase_increments, float from, float to, float glide, float depth, float rate)
+{
+    const float dt = 1.f / SAMPLE_RATE;
+    MusicLib::PitchMod pitch_mod{glide};
+    float sink = 0;
+
+    pitch_mod.vibrato(depth, rate);
+    pitch_mod.note_on(440 * std::exp2(from / 12));
+    pitch_mod.note_on(440 * std::exp2(to / 12));
+
+    for (size_t offset = 0; offset < NUM_SAMPLES; offset += BLOCK_SIZE)
+    {
+        pitch_mod.process_block(dt, phase_increments, BLOCK_SIZE);
+        sink += phase_increments[BLOCK_SIZE - 1];
+    }
+
+    return sink;
+}
+
+double time_per_sample(float (*render)(float*, float, float, float, float, float))
+{
+    static float phase_increments[BLOCK_SIZE];
+
+    auto start_time = std::chrono::steady_clock::now();
+    volatile float sink = render(phase_increments, -12, 12, 10, .3, 6);
+    (void) sink;
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() * 1e9 / NUM_SAMPLES;
+}
+
+int main()
+{
+    // The error bound of Util::exp2_fast, over the range of pitches in
+    // semitones around A4 that voices use.
+    double error_max = 0;
+    for (float x = -10; x < 10; x += 1e-4f)
+    {
+        double exact = std::exp2((double) x);
+        error_max = std::max(error_max, std::abs(MusicLib::Util::exp2_fast(x) - exact) / exact);
+    }
+
+    std::printf("exp2_fast maximum relative error: %.3g (%.4f cents)\n\n", error_max,
+        1200 * std::log2(1 + error_max));
+
+    std::printf("Glide and vibrato, per sample:\n");
+    std::printf("%-12s %8.2f ns\n", "std::pow", time_per_sample(render_pow));
+    std::printf("%-12s %8.2f ns\n", "PitchMod", time_per_sample(render_pitch_mod));
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "pitch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define NUM_RUNS 5
+
+using namespace MusicLib::literals;
+
+// A chord spelled at compile time.
+constexpr unsigned int chord[] = {"C4"_pitch, "Eb4"_pitch, "G4"_pitch, "Bb4"_pitch};
+
+/**
+ * @brief Every combination of these letters, accidentals and octaves, valid
+ * or not.
+ */
+std::vector<std::string> make_names()
+{
+    const char* letters[] = {"A", "B", "C", "D", "E", "F", "G", "H", "c", ""};
+    const char* accidentals[] = {"", "#", "x", "b", "bb", "bbb", "##", "x#"};
+    const char* octaves[] = {"-2", "-1", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11",
+        "04", "-", "", "4.", "--1", "+4"};
+
+    std::vector<std::string> names;
+    for (const char* letter : letters)
+    {
+        for (const char* accidental : accidentals)
+        {
+            for (const char* octave : octaves)
+            {
+                names.push_back(std::string{letter} + accidental + octave);
+            }
+        }
+    }
+
+    return names;
+}
+
+/**
+ * @brief Run a conversion of all the names a few times and return the best
+ * time per name, in nanoseconds.
+ */
+template <typename F>
+double bench(const std::vector<std::string>& names, size_t repeats, F&& convert)
+{
+    double best = 1e30;
+
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            convert();
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+    }
+
+    return best * 1e9 / (names.size() * repeats);
+}
+
+int main()
+{
+    std::vector<std::string> names = make_names();
+    std::vector<std::string_view> views(names.begin(), names.end());
+    std::vector<unsigned int> midi_values(names.size());
+
+    // Check the parser against the regex-based original.
+    size_t valid = 0;
+    for (const auto& name : names)
+    {
+        auto pitch = MusicLib::parse_diatonic_pitch(name);
+        auto expected = MusicLib::parse_diatonic_pitch_regex(name);
+
+        if (pitch.has_value() != expected.has_value()
+            || (pitch.has_value() && pitch->midi_value() != expected->midi_value()))
+        {
+            std::printf("Mismatch on \"%s\".\n", name.c_str());
+            return 1;
+        }
+
+        valid += pitch.has_value();
+    }
+
+    std::printf("%zu of %zu names are valid, and both parsers agree on all of them.\n", valid, names.size());
+    std::printf("Chord: %u %u %u %u\n\n", chord[0], chord[1], chord[2], chord[3]);
+
+    unsigned int sum = 0;
+
+    double regex_time = bench(names, 1, [&]
+    {
+        for (const auto& name : names)
+        {
+            auto pitch = MusicLib::parse_diatonic_pitch_regex(name);
+            sum += pitch.has_value() ? pitch->midi_value() : 0;
+        }
+    });
+
+    double parser_time = bench(names, 1000, [&]
+    {
+        for (auto name : views)
+        {
+            auto pitch = MusicLib::parse_diatonic_pitch(name);
+            sum += pitch.has_value() ? pitch->midi_value() : 0;
+        }
+    });
+
+    // Only valid MIDI pitches, so that the whole batch is converted.
+    std::vector<std::string_view> midi_names;
+    std::copy_if(views.begin(), views.end(), std::back_inserter(midi_names),
+        [](std::string_view name) { return MusicLib::midi_from_name(name).has_value(); });
+
+    double bulk_time = bench(names, 1000, [&]
+    {
+        sum += MusicLib::midi_from_names(midi_names, midi_values);
+        sum += midi_values[0];
+    }) * names.size() / midi_names.size();
+
+    std::printf("Time per name (ns)\n");
+    std::printf("  regex             %10.1f\n", regex_time);
+    std::printf("  parser            %10.1f\n", parser_time);
+    std::printf("  midi_from_names   %10.1f\n", bulk_time);
+
+    // Keep the results alive.
+    return sum == 0xffffffff;
+}
@@ -0,0 +1,224 @@
+#include "mapped_file.hpp"
+#include "song_parser.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define NUM_LINES 4000000
+#define NUM_RUNS 5
+#define CHUNK_SIZE (64 * 1024)
+
+/**
+ * @brief What each parser extracts from a line: the command and its numbers,
+ * folded into a checksum so that the parsers can be compared and none of the
+ * work can be optimized away.
+ */
+struct Checksum
+{
+    size_t commands = 0;
+    double sum = 0;
+
+    bool operator==(const Checksum& other) const = default;
+};
+
+/**
+ * @brief A song of random commands in the custom_format_1 text format.
+ */
+std::string generate(size_t lines)
+{
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<int> ins{0, 31};
+    std::uniform_int_distribution<int> pitch{36, 96};
+    std::uniform_int_distribution<int> kind{0, 9};
+    std::uniform_int_distribution<int> hundredths{1, 100};
+
+    std::string text;
+    char line[64];
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        int k = kind(rng);
+        if (k < 8)
+        {
+            std::snprintf(line, sizeof(line), "N %d %.2f %d\n", ins(rng), hundredths(rng) / 100., pitch(rng));
+        }
+        else if (k == 8)
+        {
+            std::snprintf(line, sizeof(line), "V %d %.2f\n", ins(rng), hundredths(rng) / 100.);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "W %d %d\n", ins(rng), hundredths(rng) % 3);
+        }
+
+        text += line;
+    }
+
+    return text;
+}
+
+/**
+ * @brief The way the demo used to parse songs: a string per line, a string
+ * stream and a vector of strings to split it, and std::stoi and std::stof.
+ */
+Checksum parse_stream(std::string_view text)
+{
+    Checksum checksum;
+    std::istringstream file{std::string{text}};
+    std::string line;
+    std::string token;
+
+    while (std::getline(file, line))
+    {
+        std::stringstream ss(line);
+        std::vector<std::string> tokens;
+
+        while (std::getline(ss, token, ' '))
+        {
+            tokens.push_back(token);
+        }
+
+        if (tokens.size() < 3)
+        {
+            continue;
+        }
+
+        try
+        {
+            checksum.sum += std::stoi(tokens[1]) + std::stof(tokens[2]);
+            if (tokens[0][0] == 'N' && tokens.size() > 3)
+            {
+                checksum.sum += std::stoi(tokens[3]);
+            }
+            ++checksum.commands;
+        }
+        catch (const std::exception& e)
+        {
+        }
+    }
+
+    return checksum;
+}
+
+void parse_lines(MusicLib::SongParser& parser, Checksum& checksum)
+{
+    MusicLib::SongLine line;
+    int ins;
+    float amount;
+    int pitch;
+
+    while (parser.next(line))
+    {
+        if (!line.get(1, ins) || !line.get(2, amount))
+        {
+            parser.error(line, "invalid arguments");
+            continue;
+        }
+
+        checksum.sum += ins + amount;
+        if (line[0][0] == 'N' && line.get(3, pitch))
+        {
+            checksum.sum += pitch;
+        }
+        ++checksum.commands;
+    }
+}
+
+/**
+ * @brief Parse the whole text in place.
+ */
+Checksum parse_whole(std::string_view text)
+{
+    Checksum checksum;
+    MusicLib::SongParser parser{text};
+
+    parse_lines(parser, checksum);
+    return checksum;
+}
+
+/**
+ * @brief Parse the text in chunks, as if it were being read from a file.
+ */
+Checksum parse_chunked(std::string_view text)
+{
+    Checksum checksum;
+    MusicLib::SongParser parser;
+
+    for (size_t offset = 0; offset < text.size(); offset += CHUNK_SIZE)
+    {
+        parser.feed(text.substr(offset, CHUNK_SIZE));
+        parse_lines(parser, checksum);
+    }
+
+    parser.finish();
+    parse_lines(parser, checksum);
+    return checksum;
+}
+
+/**
+ * @brief Run a parser a few times and print its best throughput.
+ */
+Checksum bench(const char* name, Checksum (*parse)(std::string_view), std::string_view text)
+{
+    Checksum checksum;
+    double best = 1e30;
+
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        checksum = parse(text);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+    }
+
+    std::printf("%-24s %10.1f MB/s %10.1f M lines/s\n", name, text.size() / best / 1e6,
+        MusicLib::SongParser::count_lines(text) / best / 1e6);
+    return checksum;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string generated;
+    std::optional<MusicLib::MappedFile> file;
+    std::string_view text;
+
+    try
+    {
+        if (argc > 1)
+        {
+            file.emplace(argv[1], true);
+            text = file->text();
+        }
+        else
+        {
+            generated = generate(NUM_LINES);
+            text = generated;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("Parsing %.1f MB, %zu lines.\n\n", text.size() / 1e6, MusicLib::SongParser::count_lines(text));
+
+    Checksum stream = bench("getline + stringstream", parse_stream, text);
+    Checksum whole = bench("SongParser", parse_whole, text);
+    Checksum chunked = bench("SongParser, 64 KB chunks", parse_chunked, text);
+
+    if (!(whole == chunked) || whole.commands != stream.commands)
+    {
+        std::fprintf(stderr, "The parsers disagree.\n");
+        return 1;
+    }
+
+    return 0;
+}
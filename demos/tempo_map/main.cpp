@@ -0,0 +1,148 @@
+#include "tempo_map.hpp"
+#include "time_manager.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define SAMPLE_RATE 44100
+#define BPM 133
+#define STEPS_PER_BEAT 4
+#define NUM_CHANGES 1000
+#define NUM_LOOKUPS 1000000
+
+/**
+ * @brief The way TimeManagerTempo used to keep time: a whole number of
+ * samples per step.
+ */
+unsigned long truncated_sample_of_step(unsigned long step)
+{
+    float step_duration = 60.0f / (BPM * STEPS_PER_BEAT);
+    return step * (unsigned long) (SAMPLE_RATE * step_duration);
+}
+
+/**
+ * @brief Play steps with live tempo and shuffle changes sent along the way,
+ * and check that the tempo map still places every step that was played at
+ * the sample it played at, so that seeking back to it is exact.
+ */
+bool check_live_changes()
+{
+    MusicLib::TempoMap tempo_map{SAMPLE_RATE, 120, STEPS_PER_BEAT};
+    tempo_map.change(40, 100, .6);
+
+    MusicLib::TimeManagerTempo time_mgr{tempo_map};
+    std::vector<unsigned long> played{0};
+
+    while (played.size() <= 64)
+    {
+        // Changes sent while the step before this one is in progress.
+        unsigned long step = played.size();
+
+        if (step % 4 == 1)
+        {
+            time_mgr.bpm(60 + 10 * (step % 13));
+        }
+        if (step % 6 == 3)
+        {
+            time_mgr.shuffle(.5 + (step % 5) / 20.);
+        }
+
+        time_mgr.count_samples(time_mgr.samples_until_step());
+        played.push_back(time_mgr.sample());
+    }
+
+    for (unsigned long step = 0; step < played.size(); ++step)
+    {
+        MusicLib::TimeManagerTempo seeker{time_mgr.tempo_map()};
+        seeker.seek(played[step]);
+
+        if (time_mgr.tempo_map().sample_of_step(step) != played[step] || seeker.step() != step)
+        {
+            std::fprintf(stderr, "Step %lu played at sample %lu, but the map puts it at %lu.\n",
+                step, played[step], time_mgr.tempo_map().sample_of_step(step));
+            return false;
+        }
+    }
+
+    std::printf("Live changes: %zu steps played where the map puts them.\n\n", played.size());
+    return true;
+}
+
+int main()
+{
+    if (!check_live_changes())
+    {
+        return 1;
+    }
+
+    // Drift over an hour at a constant tempo.
+    MusicLib::TempoMap constant{SAMPLE_RATE, BPM, STEPS_PER_BEAT};
+    unsigned long steps = BPM * STEPS_PER_BEAT * 60;
+    double exact = steps * SAMPLE_RATE * 60.0 / (BPM * STEPS_PER_BEAT);
+
+    std::printf("Step %lu (one hour at %d BPM) is due at sample %.0f.\n", steps, BPM, exact);
+    std::printf("%-22s %10lu (%+.0f ms)\n", "Whole samples per step", truncated_sample_of_step(steps),
+        (truncated_sample_of_step(steps) - exact) * 1000 / SAMPLE_RATE);
+    std::printf("%-22s %10lu (%+.0f ms)\n\n", "TempoMap", constant.sample_of_step(steps),
+        (constant.sample_of_step(steps) - exact) * 1000 / SAMPLE_RATE);
+
+    // A map with many tempo and shuffle changes.
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<int> bpm{60, 180};
+    std::uniform_int_distribution<int> gap{1, 64};
+    std::uniform_real_distribution<float> shuffle{.5, .7};
+
+    MusicLib::TempoMap changing{SAMPLE_RATE, BPM, STEPS_PER_BEAT};
+    unsigned long step = 0;
+    for (int i = 0; i < NUM_CHANGES; ++i)
+    {
+        step += gap(rng);
+        changing.change(step, bpm(rng), shuffle(rng));
+    }
+
+    unsigned long last_step = step + 64;
+    unsigned long last_sample = changing.sample_of_step(last_step);
+    std::uniform_int_distribution<unsigned long> sample{0, last_sample};
+
+    // Seek to random samples by walking a time manager from the start, as
+    // seeking used to require, and with the map.
+    unsigned long walk_checksum = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i)
+    {
+        unsigned long target = sample(rng);
+        MusicLib::TimeManagerTempo time_mgr{changing};
+
+        while (time_mgr.sample() + time_mgr.samples_until_step() <= target)
+        {
+            time_mgr.count_samples(time_mgr.samples_until_step());
+        }
+
+        walk_checksum += time_mgr.step() - changing.step_at_sample(target);
+    }
+    double walk = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() / 10;
+
+    unsigned long checksum = 0;
+    start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_LOOKUPS; ++i)
+    {
+        checksum += changing.sample_of_step(changing.step_at_sample(sample(rng)));
+    }
+    double lookup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() / NUM_LOOKUPS;
+    volatile unsigned long sink = checksum;
+    (void) sink;
+
+    std::printf("Seeking in %lu steps with %d tempo changes:\n", last_step, NUM_CHANGES);
+    std::printf("%-22s %10.0f ns\n", "Step by step", walk * 1e9);
+    std::printf("%-22s %10.0f ns\n", "TempoMap", lookup * 1e9);
+
+    if (walk_checksum != 0)
+    {
+        std::fprintf(stderr, "The walk and the map disagree.\n");
+        return 1;
+    }
+
+    return 0;
+}
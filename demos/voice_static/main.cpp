@@ -0,0 +1,97 @@
+#include "envelope.hpp"
+#include "osc.hpp"
+#include "voice.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#define SAMPLE_RATE 44100
+#define NUM_SAMPLES (1 << 16)
+#define BLOCK_SIZE 64
+#define NUM_RUNS 31
+
+/**
+ * @brief Render a note with a voice, a sample or a block at a time, and
+ * return the time it took per sample, in nanoseconds.
+ */
+template <typename V>
+double render(V& voice, bool is_block, float* out)
+{
+    const float dt = 1.f / SAMPLE_RATE;
+
+    voice.note_off();
+    voice.note_on(220);
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (is_block)
+    {
+        for (size_t offset = 0; offset < NUM_SAMPLES; offset += BLOCK_SIZE)
+        {
+            voice.process_block(dt, out + offset, BLOCK_SIZE);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < NUM_SAMPLES; ++i)
+        {
+            voice.process(dt, out[i]);
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() * 1e9 / NUM_SAMPLES;
+}
+
+/**
+ * @brief Compare a VoiceOsc and a VoiceStatic made of the same oscillator
+ * and envelope. Returns whether they rendered the same output.
+ */
+template <typename O>
+bool compare(const char* name, O osc)
+{
+    MusicLib::EnvelopeADSR env{.01, .1, .7, .3};
+    MusicLib::VoiceOsc<O, MusicLib::EnvelopeADSR> voice_osc{osc, env};
+    MusicLib::VoiceStatic<O, MusicLib::EnvelopeADSR> voice_static{osc, env};
+    bool is_same = true;
+
+    for (bool is_block : {false, true})
+    {
+        static float out_osc[NUM_SAMPLES];
+        static float out_static[NUM_SAMPLES];
+        double time_osc = 1e30;
+        double time_static = 1e30;
+
+        // Alternate between the voices, so that both run under the same
+        // conditions, and keep the best time of each.
+        for (int run = 0; run < NUM_RUNS; ++run)
+        {
+            time_osc = std::min(time_osc, render(voice_osc, is_block, out_osc));
+            time_static = std::min(time_static, render(voice_static, is_block, out_static));
+        }
+
+        is_same = is_same && std::equal(out_osc, out_osc + NUM_SAMPLES, out_static);
+
+        std::printf("%-16s %-10s %8.2f ns %8.2f ns %7.2fx\n", name, is_block ? "block" : "sample",
+            time_osc, time_static, time_osc / time_static);
+    }
+
+    return is_same;
+}
+
+int main()
+{
+    std::printf("%-16s %-10s %11s %11s %8s\n", "Oscillator", "Process", "VoiceOsc", "VoiceStatic", "Speedup");
+
+    bool is_same = compare("Basic saw", MusicLib::OscillatorBasic{MusicLib::osc_saw});
+    is_same = compare("Pulse", MusicLib::OscillatorPulse{.25}) && is_same;
+    is_same = compare("PolyBLEP saw", MusicLib::OscillatorPolyBLEP{}) && is_same;
+
+    if (!is_same)
+    {
+        std::fprintf(stderr, "The voices rendered different output.\n");
+        return 1;
+    }
+
+    return 0;
+}
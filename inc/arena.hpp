@@ -0,0 +1,108 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MusicLib {
+
+/**
+ * @brief A monotonic allocator. Objects are bump-allocated contiguously in
+ * large blocks and are only freed all at once, when the arena is cleared or
+ * destroyed, so creating an object is a pointer increment and clearing
+ * costs O(1) per block. The blocks are kept for reuse after clear().
+ */
+class Arena
+{
+public:
+    explicit Arena(size_t block_size = 64 * 1024);
+    ~Arena() noexcept;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief Allocate uninitialized memory. Never returns nullptr.
+     * 
+     * @param alignment A power of two.
+     */
+    void* allocate(size_t size, size_t alignment);
+
+    /**
+     * @brief Construct an object in the arena. Objects that aren't
+     * trivially destructible are destroyed by clear() and by the arena's
+     * destructor, in reverse order of creation.
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        if constexpr (std::is_trivially_destructible_v<T>)
+        {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            void* finalizer = allocate(sizeof(Finalizer), alignof(Finalizer));
+            T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+            m_finalizers = new (finalizer) Finalizer{
+                [](void* ptr) { static_cast<T*>(ptr)->~T(); }, obj, m_finalizers};
+            return obj;
+        }
+    }
+
+    /**
+     * @brief Destroy all objects and rewind to the first block.
+     */
+    void clear();
+
+    /**
+     * @brief Bytes allocated since the last clear, including padding.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Total size of the blocks.
+     */
+    size_t capacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    struct Finalizer
+    {
+        void (*destroy)(void*);
+        void* obj;
+        Finalizer* next;
+    };
+
+    void next_block(size_t min_size);
+    void finalize();
+
+private:
+    size_t m_block_size;
+    std::vector<Block> m_blocks;
+
+    // The next block to move to once the current one is full.
+    size_t m_next_block;
+
+    std::byte* m_head;
+    std::byte* m_end;
+
+    // Bytes used by the blocks before the current one.
+    size_t m_used;
+
+    Finalizer* m_finalizers;
+};
+
+}
+
+#endif // ARENA_H_
@@ -1,12 +1,17 @@
 #ifndef AUDIO_MANAGER_H_
 #define AUDIO_MANAGER_H_
 
+#include "denormals.hpp"
+
 namespace MusicLib {
     
 class AudioManager
     {
     public:
-        AudioManager() = default;
+        AudioManager()
+        : m_denormal_mode{DenormalMode::Flush}
+        {}
+
         virtual ~AudioManager() = default;
 
         virtual void start() = 0;
@@ -14,6 +19,23 @@ class AudioManager
 
         virtual unsigned int sample_rate() = 0;
         virtual float sample_duration() = 0;
+
+        /**
+         * @brief How subnormals are treated while rendering. Flushed to zero
+         * by default. Takes effect on the next start().
+         */
+        void denormal_mode(DenormalMode mode)
+        {
+            m_denormal_mode = mode;
+        }
+
+        DenormalMode denormal_mode() const
+        {
+            return m_denormal_mode;
+        }
+
+    protected:
+        DenormalMode m_denormal_mode;
     };
 }
 
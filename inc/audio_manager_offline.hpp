@@ -0,0 +1,88 @@
+#ifndef AUDIO_MANAGER_OFFLINE_H_
+#define AUDIO_MANAGER_OFFLINE_H_
+
+#include "audio_manager.hpp"
+#include "command_stream.hpp"
+#include "device.hpp"
+#include "sequencer.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace MusicLib {
+
+/**
+ * @brief An audio manager that renders without an audio device, as fast as
+ * the CPU allows. start() drives the sequencer and the main device in a
+ * loop until the command stream finishes (plus a tail for releases to
+ * ring out), and writes the interleaved stereo output into memory or a
+ * 32-bit float WAV file.
+ */
+class AudioManagerOffline : public AudioManager
+{
+public:
+    explicit AudioManagerOffline(unsigned int sample_rate, Sequencer& seq,
+        Device<InputNone, OutputStereo>& device, CommandStream& cmd_stream,
+        float tail = 1, float max_duration = 3600, unsigned int buffer_size = 512);
+    ~AudioManagerOffline() noexcept = default;
+
+    /**
+     * @brief Render the song. Blocks until the command stream finishes and
+     * the tail has been rendered, the maximal duration is reached, or stop()
+     * is called from another thread. A WAV file is limited to 4 GB, about
+     * 3.4 hours at 44.1 kHz, so rendering into a file also stops there.
+     * Throws std::runtime_error if the file can't be opened or written.
+     */
+    void start() override;
+    void stop() override;
+
+    unsigned int sample_rate() override;
+    float sample_duration() override;
+
+    /**
+     * @brief Write the output to a WAV file instead of keeping it in memory.
+     * An empty filename restores rendering into memory.
+     */
+    void output_file(const std::string& filename);
+
+    /**
+     * @brief The interleaved stereo output of the last render, if it was
+     * rendered into memory.
+     */
+    const std::vector<float>& buffer() const;
+
+    unsigned long frames_rendered() const;
+
+    /**
+     * @brief The wall clock duration of the last render, in seconds.
+     */
+    double render_time() const;
+
+    /**
+     * @brief The ratio between the duration of the rendered audio and the
+     * time it took to render it.
+     */
+    double realtime_factor() const;
+
+private:
+    unsigned int m_sample_rate;
+    unsigned int m_buffer_size;
+    float m_sample_duration;
+    float m_tail;
+    float m_max_duration;
+
+    Sequencer& m_seq;
+    Device<InputNone, OutputStereo>& m_device;
+    CommandStream& m_cmd_stream;
+
+    std::string m_filename;
+    std::vector<float> m_buffer;
+    unsigned long m_frames_rendered;
+    double m_render_time;
+    std::atomic<bool> m_running;
+};
+
+}
+
+#endif // AUDIO_MANAGER_OFFLINE_H_
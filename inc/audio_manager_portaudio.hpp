@@ -2,6 +2,7 @@
 #define AUDIO_MANAGER_PORTAUDIO_H_
 
 #include "audio_manager.hpp"
+#include "control_queue.hpp"
 #include "device.hpp"
 #include "sequencer.hpp"
 
@@ -12,25 +13,38 @@ namespace MusicLib {
 
 struct PortAudioData
 {
-    PortAudioData() = default;
+    PortAudioData()
+    : denormal_mode{DenormalMode::Flush}
+    {}
+
+    // Set by the audio manager when the stream starts.
+    DenormalMode denormal_mode;
 };
 
 struct PortAudioDataOut : public PortAudioData
 {
-    PortAudioDataOut(Sequencer& seq, Device<InputNone, OutputStereo>& device, float sample_duration);
+    PortAudioDataOut(Sequencer& seq, Device<InputNone, OutputStereo>& device, float sample_duration,
+        ControlQueue* control = nullptr);
 
     Sequencer& seq;
     Device<InputNone, OutputStereo>& device;
     float sample_duration;
+
+    // Optional. Messages from control threads, dispatched by the callback.
+    ControlQueue* control;
 };
 
 struct PortAudioDataInOut : public PortAudioData
 {
-    PortAudioDataInOut(Sequencer& seq, Device<InputStereo, OutputStereo>& device, float sample_duration);
+    PortAudioDataInOut(Sequencer& seq, Device<InputStereo, OutputStereo>& device, float sample_duration,
+        ControlQueue* control = nullptr);
 
     Sequencer& seq;
     Device<InputStereo, OutputStereo>& device;
     float sample_duration;
+
+    // Optional. Messages from control threads, dispatched by the callback.
+    ControlQueue* control;
 };
 
 
@@ -1,6 +1,8 @@
 #ifndef COMMAND_H_
 #define COMMAND_H_
 
+#include "arena.hpp"
+
 #include <memory>
 
 namespace MusicLib {
@@ -8,8 +10,14 @@ namespace MusicLib {
 struct Command
 {
     virtual std::unique_ptr<Command> clone() const = 0; 
+
+    /**
+     * @brief Copy the command into an arena, e.g. a command stream's
+     * storage. Typically implemented as arena.create<T>(*this).
+     */
+    virtual Command* clone_into(Arena& arena) const = 0;
 };
 
 };
 
-#endif // COMMAND_H_
\ No newline at end of file
+#endif // COMMAND_H_
@@ -5,11 +5,39 @@
 #include "device.hpp"
 #include "time_manager.hpp"
 
+#include <concepts>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <variant>
 #include <functional>
 
 namespace MusicLib {
+
+/**
+ * @brief The objects a command acts on, as a bit mask. A command type can
+ * declare the targets of each command with a method
+ * CommandTarget targets() const, and statically dispatching processors skip
+ * the handlers of the others.
+ */
+enum class CommandTarget : uint8_t
+{
+    None = 0,
+    CommandStream = 1 << 0,
+    TimeManager = 1 << 1,
+    Device = 1 << 2,
+    All = CommandStream | TimeManager | Device
+};
+
+constexpr CommandTarget operator|(CommandTarget a, CommandTarget b)
+{
+    return (CommandTarget) ((uint8_t) a | (uint8_t) b);
+}
+
+constexpr bool has_target(CommandTarget targets, CommandTarget target)
+{
+    return ((uint8_t) targets & (uint8_t) target) != 0;
+}
     
 /**
  * @brief A command processor is given to the sequencer, which invokes the 
@@ -25,6 +53,18 @@ public:
     virtual void handle_command_stream(Command& cmd, CommandStream& cmd_stream) = 0;
     virtual void handle_device(Command& cmd, IDevice& device) = 0;
     virtual void handle_time_manager(Command& cmd, TimeManager& time_mgr) = 0;
+
+    /**
+     * @brief Handle a command from the command stream: call the command
+     * stream, time manager and device handlers, in that order. Derived
+     * classes can override it to dispatch all three in one call.
+     */
+    virtual void handle(Command& cmd, CommandStream& cmd_stream, TimeManager& time_mgr, IDevice& device)
+    {
+        handle_command_stream(cmd, cmd_stream);
+        handle_time_manager(cmd, time_mgr);
+        handle_device(cmd, device);
+    }
 };
 
 /**
@@ -85,6 +125,119 @@ private:
     std::function<void(Command&, TimeManager&)> m_time_handler;
 };
 
+/**
+ * @brief A command processor whose handlers are bound at compile time, so
+ * they're inlined into a single dispatch per command instead of going
+ * through a std::function each.
+ * 
+ * Each handler is a function (or a captureless lambda) that takes C& and
+ * one of CS&, D& or TM&, and several may share a target. Targets without a
+ * handler are skipped at compile time. If C declares targets(), handlers
+ * of targets a command doesn't touch are skipped too.
+ * 
+ * @tparam C Command type.
+ * @tparam CS Command stream type.
+ * @tparam D Device type.
+ * @tparam TM Time manager type.
+ * @tparam Handlers The handler functions.
+ */
+template <typename C, typename CS, typename D, typename TM, auto... Handlers>
+class CommandProcessorStatic final : public CommandProcessor
+{
+    static_assert(std::is_base_of_v<Command, C>, "class C must be derived from Command");
+    static_assert(std::is_base_of_v<CommandStream, CS>, "class CS must be derived from CommandStream");
+    static_assert(std::is_base_of_v<IDevice, D>, "class D must be derived from IDevice");
+    static_assert(std::is_base_of_v<TimeManager, TM>, "class TM must be derived from TimeManager");
+    static_assert(((std::is_invocable_v<decltype(Handlers), C&, CS&>
+        || std::is_invocable_v<decltype(Handlers), C&, D&>
+        || std::is_invocable_v<decltype(Handlers), C&, TM&>) && ...),
+        "every handler must take (C&, CS&), (C&, D&) or (C&, TM&)");
+
+public:
+    explicit CommandProcessorStatic() = default;
+    ~CommandProcessorStatic() noexcept = default;
+
+    void handle_command_stream(Command& cmd, CommandStream& cmd_stream) override
+    {
+        call(static_cast<C&>(cmd), static_cast<CS&>(cmd_stream));
+    }
+
+    void handle_device(Command& cmd, IDevice& device) override
+    {
+        call(static_cast<C&>(cmd), static_cast<D&>(device));
+    }
+
+    void handle_time_manager(Command& cmd, TimeManager& time_mgr) override
+    {
+        call(static_cast<C&>(cmd), static_cast<TM&>(time_mgr));
+    }
+
+    void handle(Command& cmd, CommandStream& cmd_stream, TimeManager& time_mgr, IDevice& device) override
+    {
+        auto& cmd_cast = static_cast<C&>(cmd);
+        CommandTarget targets = targets_of(cmd_cast);
+
+        if constexpr (has_handler<CS>)
+        {
+            if (has_target(targets, CommandTarget::CommandStream))
+            {
+                call(cmd_cast, static_cast<CS&>(cmd_stream));
+            }
+        }
+
+        if constexpr (has_handler<TM>)
+        {
+            if (has_target(targets, CommandTarget::TimeManager))
+            {
+                call(cmd_cast, static_cast<TM&>(time_mgr));
+            }
+        }
+
+        if constexpr (has_handler<D>)
+        {
+            if (has_target(targets, CommandTarget::Device))
+            {
+                call(cmd_cast, static_cast<D&>(device));
+            }
+        }
+    }
+
+    /**
+     * @brief The targets the command declares, or all of them if its type
+     * doesn't declare any.
+     */
+    static CommandTarget targets_of(const C& cmd)
+    {
+        if constexpr (requires { { cmd.targets() } -> std::same_as<CommandTarget>; })
+        {
+            return cmd.targets();
+        }
+        else
+        {
+            return CommandTarget::All;
+        }
+    }
+
+private:
+    template <typename T>
+    static constexpr bool has_handler = (std::is_invocable_v<decltype(Handlers), C&, T&> || ...);
+
+    /**
+     * @brief Call every handler of the target, in the order they're given.
+     */
+    template <typename T>
+    static void call(C& cmd, T& target)
+    {
+        ([&]
+        {
+            if constexpr (std::is_invocable_v<decltype(Handlers), C&, T&>)
+            {
+                Handlers(cmd, target);
+            }
+        }(), ...);
+    }
+};
+
 }
 
 
@@ -5,7 +5,10 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <span>
+#include <type_traits>
 
+#include "arena.hpp"
 #include "command.hpp"
 #include "instrument.hpp"
 
@@ -31,6 +34,51 @@ public:
     virtual void cursor(unsigned long index) = 0;
 };
 
+/**
+ * @brief A sequence of commands stored contiguously in an arena.
+ * 
+ * Copies share the arena, so copying costs no allocation per command, and
+ * commands must not be modified once added. Adding to storage whose arena
+ * is shared first copies the commands into an arena of its own.
+ */
+class CommandStorage
+{
+public:
+    explicit CommandStorage();
+    explicit CommandStorage(const std::vector<std::unique_ptr<Command>>& commands);
+    ~CommandStorage() noexcept = default;
+    CommandStorage(const CommandStorage&) = default;
+    CommandStorage& operator=(const CommandStorage&) = default;
+    CommandStorage(CommandStorage&&) noexcept = default;
+    CommandStorage& operator=(CommandStorage&&) noexcept = default;
+
+    void add(const Command& command);
+
+    Command* operator[](size_t index) const
+    {
+        return m_commands[index];
+    }
+
+    size_t size() const
+    {
+        return m_commands.size();
+    }
+
+    void reserve(size_t size);
+
+    /**
+     * @brief Remove all commands, freeing the arena if it isn't shared.
+     */
+    void clear();
+
+private:
+    void own_arena();
+
+private:
+    std::shared_ptr<Arena> m_arena;
+    std::vector<Command*> m_commands;
+};
+
 /**
  * @brief The simplest command stream, with a single vector of commands.
  * offloads the entire effort of playing the instruments and keeping track 
@@ -42,8 +90,8 @@ public:
     explicit CommandStreamBasic(bool looping = false);
     explicit CommandStreamBasic(std::vector<std::unique_ptr<Command>>& commands, bool looping = false);
     ~CommandStreamBasic() noexcept = default;
-    CommandStreamBasic(const CommandStreamBasic& other);
-    CommandStreamBasic& operator=(const CommandStreamBasic& other);
+    CommandStreamBasic(const CommandStreamBasic&) = default;
+    CommandStreamBasic& operator=(const CommandStreamBasic&) = default;
     CommandStreamBasic(CommandStreamBasic&&) noexcept = default;
     CommandStreamBasic& operator=(CommandStreamBasic&&) noexcept = default;
 
@@ -57,7 +105,7 @@ public:
     void cursor(unsigned long cursor) override;
 
 private:
-    std::vector<std::unique_ptr<Command>> m_commands;
+    CommandStorage m_commands;
     unsigned long m_cursor;
     bool m_looping;
 };
@@ -72,8 +120,8 @@ public:
     explicit CommandStreamInstrument(IInstrument& ins, bool looping = false);
     explicit CommandStreamInstrument(std::vector<std::unique_ptr<Command>>& commands, IInstrument& ins, bool looping = false);
     ~CommandStreamInstrument() noexcept = default;
-    CommandStreamInstrument(const CommandStreamInstrument& other);
-    CommandStreamInstrument& operator=(const CommandStreamInstrument& other);
+    CommandStreamInstrument(const CommandStreamInstrument&) = default;
+    CommandStreamInstrument& operator=(const CommandStreamInstrument&) = default;
     CommandStreamInstrument(CommandStreamInstrument&&) noexcept = default;
     CommandStreamInstrument& operator=(CommandStreamInstrument&&) noexcept = default;
 
@@ -90,13 +138,147 @@ public:
     IInstrument& instrument();
 
 private:
-    std::vector<std::unique_ptr<Command>> m_commands;
+    CommandStorage m_commands;
     unsigned long m_cursor;
     bool m_looping;
 
     std::reference_wrapper<IInstrument> m_ins;
 };
 
+/**
+ * @brief A command stream that holds commands of a single concrete type by
+ * value, in one contiguous vector. Adding a command copies it without
+ * allocating once capacity is reserved, and stepping is an index increment.
+ * 
+ * The class is final, so calls through the concrete type are resolved
+ * statically, and current_command() gives code that is templated on the
+ * stream type the command without a virtual call or a cast.
+ * 
+ * @tparam C Command type.
+ */
+template <typename C>
+class CommandStreamFlat final : public CommandStream
+{
+    static_assert(std::is_base_of_v<Command, C>, "class C must be derived from Command");
+
+public:
+    explicit CommandStreamFlat(bool looping = false)
+    : m_commands{}
+    , m_cursor{0}
+    , m_looping{looping}
+    {}
+
+    /**
+     * @brief Load a whole song with a single allocation.
+     */
+    explicit CommandStreamFlat(std::span<const C> commands, bool looping = false)
+    : m_commands(commands.begin(), commands.end())
+    , m_cursor{0}
+    , m_looping{looping}
+    {}
+
+    ~CommandStreamFlat() noexcept = default;
+    CommandStreamFlat(const CommandStreamFlat&) = default;
+    CommandStreamFlat& operator=(const CommandStreamFlat&) = default;
+    CommandStreamFlat(CommandStreamFlat&&) noexcept = default;
+    CommandStreamFlat& operator=(CommandStreamFlat&&) noexcept = default;
+
+    /**
+     * @brief Add a command. It must be of type C.
+     */
+    void add(Command& command) override
+    {
+        m_commands.push_back(static_cast<const C&>(command));
+    }
+
+    void add(const C& command)
+    {
+        m_commands.push_back(command);
+    }
+
+    /**
+     * @brief Append a range of commands, growing the storage at most once.
+     */
+    void add(std::span<const C> commands)
+    {
+        m_commands.insert(m_commands.end(), commands.begin(), commands.end());
+    }
+
+    void reserve(size_t size)
+    {
+        m_commands.reserve(size);
+    }
+
+    size_t size() const
+    {
+        return m_commands.size();
+    }
+
+    std::span<const C> commands() const
+    {
+        return m_commands;
+    }
+
+    Command* current() const override
+    {
+        if (m_cursor >= m_commands.size())
+        {
+            return nullptr;
+        }
+
+        // The interface hands out mutable commands.
+        return const_cast<C*>(&m_commands[m_cursor]);
+    }
+
+    /**
+     * @brief The current command. The stream must not be empty.
+     */
+    const C& current_command() const
+    {
+        return m_commands[m_cursor];
+    }
+
+    bool finished() const override
+    {
+        return !m_looping && m_cursor >= m_commands.size() - 1;
+    }
+
+    void reset() override
+    {
+        cursor(0);
+    }
+
+    unsigned long step() override
+    {
+        if (m_cursor < m_commands.size() - 1)
+        {
+            ++m_cursor;
+        }
+        else
+        {
+            if (m_looping)
+            {
+                m_cursor = 0;
+            }
+        }
+
+        return m_cursor;
+    }
+
+    void cursor(unsigned long cursor) override
+    {
+        if (cursor < m_commands.size())
+        {
+            m_cursor = cursor;
+        }
+    }
+
+private:
+    std::vector<C> m_commands;
+    unsigned long m_cursor;
+    bool m_looping;
+};
+
 };
 
 #endif // COMMAND_STREAM_H_
\ No newline at end of file
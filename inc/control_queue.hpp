@@ -0,0 +1,187 @@
+#ifndef CONTROL_QUEUE_H_
+#define CONTROL_QUEUE_H_
+
+#include "command.hpp"
+#include "sequencer.hpp"
+#include "spsc_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+namespace MusicLib {
+
+/**
+ * @brief The audio thread's side of a queue of transport and command
+ * messages sent from a control thread. The audio callback dispatches due
+ * messages to the sequencer between blocks, so the control thread never
+ * touches the sequencer, time manager or devices directly.
+ *
+ * Messages carry a timestamp in samples, counted by the queue's clock since
+ * the stream started. A message is applied at the start of the first block
+ * that reaches its timestamp; the callback splits blocks so that this
+ * happens on the exact sample.
+ */
+class ControlQueue
+{
+public:
+    ControlQueue() = default;
+    virtual ~ControlQueue() = default;
+
+    /**
+     * @brief The number of samples until the next message is due, 0 if it's
+     * due now, or the maximal value of unsigned long if the queue is empty.
+     */
+    virtual unsigned long samples_until_message() const = 0;
+
+    /**
+     * @brief Apply every message that is due to the sequencer.
+     */
+    virtual void dispatch(Sequencer& seq) = 0;
+
+    /**
+     * @brief Progress the queue's clock.
+     */
+    virtual void advance(unsigned long samples) = 0;
+
+    /**
+     * @brief The number of samples rendered so far. Can be read from any
+     * thread, e.g. to schedule a message a fixed latency ahead.
+     */
+    virtual unsigned long time() const = 0;
+};
+
+/**
+ * @brief A control queue for a single concrete command type, backed by a
+ * wait-free SPSC ring buffer. Only one thread may send messages.
+ *
+ * @tparam C Command type. Copied into preallocated slots, so it should be
+ * copyable without allocating.
+ * @tparam N Capacity. Must be a power of two.
+ */
+template <typename C, size_t N = 256>
+class ControlQueueBasic : public ControlQueue
+{
+    static_assert(std::is_base_of_v<Command, C>, "class C must be derived from Command");
+
+public:
+    struct Message
+    {
+        enum class Type
+        {
+            Play,
+            Pause,
+            Stop,
+            Command
+        } type;
+
+        unsigned long time;
+        C command;
+    };
+
+public:
+    explicit ControlQueueBasic()
+    : m_queue{}
+    , m_time{0}
+    {
+    }
+
+    ~ControlQueueBasic() noexcept = default;
+
+    /**
+     * @brief Start playing. The send methods return false if the queue is
+     * full.
+     *
+     * @param time The sample at which to apply the message. Messages that
+     * are already due are applied at the start of the next block.
+     */
+    bool play(unsigned long time = 0)
+    {
+        return m_queue.push(Message{Message::Type::Play, time, C{}});
+    }
+
+    bool pause(unsigned long time = 0)
+    {
+        return m_queue.push(Message{Message::Type::Pause, time, C{}});
+    }
+
+    /**
+     * @brief Stop playing and return to the beginning of the track.
+     */
+    bool stop(unsigned long time = 0)
+    {
+        return m_queue.push(Message{Message::Type::Stop, time, C{}});
+    }
+
+    /**
+     * @brief Send a command, to be executed by the sequencer outside of its
+     * command stream.
+     */
+    bool send(const C& cmd, unsigned long time = 0)
+    {
+        return m_queue.push(Message{Message::Type::Command, time, cmd});
+    }
+
+    unsigned long samples_until_message() const override
+    {
+        const Message* msg = m_queue.front();
+
+        if (!msg)
+        {
+            return std::numeric_limits<unsigned long>::max();
+        }
+
+        unsigned long now = m_time.load(std::memory_order_relaxed);
+        return msg->time > now ? msg->time - now : 0;
+    }
+
+    void dispatch(Sequencer& seq) override
+    {
+        unsigned long now = m_time.load(std::memory_order_relaxed);
+        Message* msg;
+
+        while ((msg = m_queue.front()) && msg->time <= now)
+        {
+            switch (msg->type)
+            {
+            case Message::Type::Play:
+                seq.playing(true);
+                break;
+
+            case Message::Type::Pause:
+                seq.playing(false);
+                break;
+
+            case Message::Type::Stop:
+                seq.playing(false);
+                seq.reset();
+                break;
+
+            case Message::Type::Command:
+                seq.execute(msg->command);
+                break;
+            }
+
+            m_queue.pop();
+        }
+    }
+
+    void advance(unsigned long samples) override
+    {
+        m_time.store(m_time.load(std::memory_order_relaxed) + samples, std::memory_order_relaxed);
+    }
+
+    unsigned long time() const override
+    {
+        return m_time.load(std::memory_order_relaxed);
+    }
+
+private:
+    SPSCQueue<Message, N> m_queue;
+    std::atomic<unsigned long> m_time;
+};
+
+}
+
+#endif // CONTROL_QUEUE_H_
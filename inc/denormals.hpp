@@ -0,0 +1,56 @@
+#ifndef DENORMALS_H_
+#define DENORMALS_H_
+
+#include <cstdint>
+
+namespace MusicLib {
+
+/**
+ * @brief How subnormal floats are treated on a rendering thread.
+ */
+enum class DenormalMode
+{
+    // Leave the thread's floating point mode as it is.
+    Keep,
+
+    // Flush subnormal results to zero and treat subnormal inputs as zero
+    // (FTZ and DAZ on x86, FZ on ARM), so decaying signals can't slow the
+    // thread down once they get that small.
+    Flush
+};
+
+/**
+ * @brief Set the denormal mode of the calling thread for the guard's
+ * lifetime, and restore the previous mode when it's destroyed. Meant to
+ * wrap each audio callback, so the mode doesn't leak into a thread the
+ * library doesn't own. Does nothing on architectures it doesn't know.
+ */
+class DenormalGuard
+{
+public:
+    explicit DenormalGuard(DenormalMode mode);
+    ~DenormalGuard() noexcept;
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+    /**
+     * @brief Whether the calling thread currently flushes subnormals.
+     */
+    static DenormalMode current();
+
+    /**
+     * @brief Set the denormal mode of the calling thread until it's set
+     * again, for threads the library owns. Keep turns flushing off, as in a
+     * new thread.
+     */
+    static void set_thread_mode(DenormalMode mode);
+
+private:
+    uint64_t m_saved;
+    bool m_is_changed;
+};
+
+}
+
+#endif // DENORMALS_H_
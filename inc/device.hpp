@@ -4,6 +4,7 @@
 #include "envelope.hpp"
 #include "voice.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -85,6 +86,28 @@ public:
     virtual float vol() const = 0;
 
     virtual void process(float sample_duration, float& out) = 0;
+
+    /**
+     * @brief Render a block of samples. Falls back to calling process() once
+     * per sample; derived classes can override it with a tighter loop.
+     */
+    virtual void process_block(float sample_duration, float* out, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            process(sample_duration, out[i]);
+        }
+    }
+
+    /**
+     * @brief Whether the device outputs nothing but silence until it's
+     * changed from outside (e.g. by a note), so it can be skipped.
+     * Devices that can't tell are never idle.
+     */
+    virtual bool is_idle() const
+    {
+        return false;
+    }
 };
 
 template<>
@@ -103,6 +126,28 @@ public:
     virtual float pan() const = 0;
 
     virtual void process(float sample_duration, float& out_left, float& out_right) = 0;
+
+    /**
+     * @brief Render a block of samples. Falls back to calling process() once
+     * per sample; derived classes can override it with a tighter loop.
+     */
+    virtual void process_block(float sample_duration, float* out_left, float* out_right, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            process(sample_duration, out_left[i], out_right[i]);
+        }
+    }
+
+    /**
+     * @brief Whether the device outputs nothing but silence until it's
+     * changed from outside (e.g. by a note), so it can be skipped.
+     * Devices that can't tell are never idle.
+     */
+    virtual bool is_idle() const
+    {
+        return false;
+    }
 };
 
 template<>
@@ -118,6 +163,18 @@ public:
     virtual float vol() const = 0;
 
     virtual void process(float sample_duration, float in, float& out) = 0;
+
+    /**
+     * @brief Render a block of samples. Falls back to calling process() once
+     * per sample; derived classes can override it with a tighter loop.
+     */
+    virtual void process_block(float sample_duration, const float* in, float* out, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            process(sample_duration, in[i], out[i]);
+        }
+    }
 };
 
 template<>
@@ -136,6 +193,19 @@ public:
     virtual float pan() const = 0;
 
     virtual void process(float sample_duration, float in_left, float in_right, float& out_left, float& out_right) = 0;
+
+    /**
+     * @brief Render a block of samples. Falls back to calling process() once
+     * per sample; derived classes can override it with a tighter loop.
+     */
+    virtual void process_block(float sample_duration, const float* in_left, const float* in_right,
+        float* out_left, float* out_right, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            process(sample_duration, in_left[i], in_right[i], out_left[i], out_right[i]);
+        }
+    }
 };
 
 }
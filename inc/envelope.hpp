@@ -1,6 +1,8 @@
 #ifndef ENVELOPE_H_
 #define ENVELOPE_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace MusicLib {
@@ -15,6 +17,18 @@ public:
     virtual void trig(bool is_on) = 0;
     virtual float process(float time) = 0;
 
+    /**
+     * @brief Write the next frames envelope values into out. Falls back to
+     * calling process() once per sample.
+     */
+    virtual void process_block(float time, float* out, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            out[i] = process(time);
+        }
+    }
+
     virtual void set_retrigger(bool is_retrigger) = 0;
 
     virtual bool is_on() const = 0;
@@ -30,6 +44,7 @@ public:
 
     void trig(bool is_on) override;
     float process(float time) override;
+    void process_block(float time, float* out, size_t frames) override;
 
     void set_retrigger(bool is_retrigger) override;
 
@@ -61,6 +76,7 @@ public:
 
     void trig(bool is_on) override;
     float process(float time) override;
+    void process_block(float time, float* out, size_t frames) override;
 
     void set_retrigger(bool is_retrigger) override;
 
@@ -75,15 +91,142 @@ private:
         RELEASE
     };
 
+    void start_stage(Stage stage);
+    void update_slope(float sample_duration);
+    float ramp(int32_t position) const;
+    bool is_stage_over(float level) const;
+    void end_stage();
+    size_t samples_in_stage(size_t frames) const;
+
 private:
     float m_level;
     float m_level_raw;
 
+    // The attack, decay and release are linear ramps, computed from the
+    // level at which the ramp started and the number of samples since,
+    // rather than accumulated, so that a block of them can be computed at
+    // once and still match the per-sample output exactly. The ramp starts
+    // over whenever the slope changes.
+    float m_stage_start;
+    int32_t m_stage_position;
+    float m_slope;
+
+    float m_attack;
+    float m_decay;
+    float m_sustain;
+    float m_release;
+
+    Stage m_stage;
+
+    bool m_is_retrigger;
+};
+
+/**
+ * @brief An ADSR envelope with exponential segments, like an analog
+ * envelope generator charging a capacitor towards a target beyond the end
+ * of each segment.
+ *
+ * Each segment is a one-pole recurrence, level = base + level * coef, whose
+ * coefficients are computed when a parameter changes, and cached for the
+ * sample rate they were computed for. Processing a sample takes a single
+ * multiply-add, with no division.
+ *
+ * The curvature of a segment is set by how far its target overshoots the
+ * segment's end, relative to the segment's height (for the release, the
+ * level it starts from), so that segments take their set times whatever the
+ * sustain level: a small overshoot gives a sharply curved segment, and a
+ * large one an almost linear segment. Overshoots below overshoot_min, which
+ * would make a segment jump or the envelope output NaN, are clamped to it. A
+ * segment whose steps fall below float precision before reaching its end,
+ * as very small overshoots do, ends there.
+ */
+class EnvelopeExp : public Envelope
+{
+public:
+    static constexpr float overshoot_min = 1e-6;
+
+public:
+    explicit EnvelopeExp(float attack = .01, float decay = 1, float sustain = 1, float release = .01,
+        bool is_retrigger = true, float attack_overshoot = .3, float decay_overshoot = .0001);
+    ~EnvelopeExp() noexcept = default;
+
+    std::unique_ptr<Envelope> clone() const override;
+
+    float attack() const;
+    void attack(float attack);
+
+    float decay() const;
+    void decay(float decay);
+
+    float sustain() const;
+    void sustain(float sustain);
+
+    float release() const;
+    void release(float release);
+
+    /**
+     * @brief The overshoot of the attack segment.
+     */
+    float attack_overshoot() const;
+    void attack_overshoot(float overshoot);
+
+    /**
+     * @brief The overshoot of the decay and release segments.
+     */
+    float decay_overshoot() const;
+    void decay_overshoot(float overshoot);
+
+    void trig(bool is_on) override;
+    float process(float time) override;
+    void process_block(float time, float* out, size_t frames) override;
+
+    void set_retrigger(bool is_retrigger) override;
+
+    bool is_on() const override;
+
+private:
+    enum Stage {
+        OFF,
+        ATTACK,
+        DECAY,
+        SUSTAIN,
+        RELEASE
+    };
+
+    struct Segment
+    {
+        float base;
+        float coef;
+    };
+
+    void update_coefficients();
+    void update_release_segment();
+
+    template <Stage S>
+    size_t render(float* out, size_t frames);
+
+private:
+    float m_level;
+
     float m_attack;
     float m_decay;
     float m_sustain;
     float m_release;
 
+    float m_attack_overshoot;
+    float m_decay_overshoot;
+
+    // The sample duration the segments were computed for, or 0 if they
+    // haven't been yet.
+    float m_sample_duration;
+    Segment m_attack_segment;
+    Segment m_decay_segment;
+    Segment m_release_segment;
+
+    // The level the release started from. Its target's overshoot is relative
+    // to it.
+    float m_release_level;
+
     Stage m_stage;
 
     bool m_is_retrigger;
@@ -4,6 +4,10 @@
 #include "device.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -106,6 +110,11 @@ public:
         return m_vol;
     }
 
+    bool is_idle() const override
+    {
+        return !m_voice->is_on();
+    }
+
     template <typename V2 = V>
     V2& voice()
     {
@@ -130,13 +139,23 @@ public:
         return static_cast<const V2&>(*m_voice[index]);
     }
 
-    void process(float sample_duration, float& out) 
+    void process(float sample_duration, float& out) override
     {
         float temp = 0;
-        m_voice.process(sample_duration, temp);
+        m_voice->process(sample_duration, temp);
         out = temp * m_vol;
     }
 
+    void process_block(float sample_duration, float* out, size_t frames) override
+    {
+        m_voice->process_block(sample_duration, out, frames);
+
+        for (size_t i = 0; i < frames; ++i)
+        {
+            out[i] *= m_vol;
+        }
+    }
+
 private:
     std::unique_ptr<V> m_voice;
     float m_vol;
@@ -239,6 +258,11 @@ public:
         return m_pan;
     }
 
+    bool is_idle() const override
+    {
+        return !m_voice->is_on();
+    }
+
     template <typename V2 = V>
     V2& voice()
     {
@@ -276,12 +300,574 @@ public:
         out_left *= 1 - m_pan;
     }
 
+    void process_block(float sample_duration, float* out_left, float* out_right, size_t frames) override
+    {
+        m_voice->process_block(sample_duration, out_left, frames);
+
+        for (size_t i = 0; i < frames; ++i)
+        {
+            float out = m_vol * out_left[i];
+
+            // Pan
+            out_right[i] = out * m_pan;
+            out_left[i] = out * (1 - m_pan);
+        }
+    }
+
 private:
     std::unique_ptr<V> m_voice;
     float m_vol;
     float m_pan;
 };
 
+/**
+ * @brief Which voice a VoicePool takes over when a note starts and every
+ * voice is sounding. Voices that were already released are always taken
+ * over before voices that are still held.
+ */
+enum class VoiceStealing
+{
+    Oldest,
+    Quietest
+};
+
+/**
+ * @brief A fixed set of voices cloned from a template voice, shared by the
+ * notes of a polyphonic instrument.
+ *
+ * All the voices are cloned once at construction, and the bookkeeping is
+ * preallocated, so starting and stopping notes and rendering never
+ * allocate. Free voices are kept on a stack, so a note gets a voice in O(1)
+ * unless it has to steal one. Notes are identified by a key chosen by the
+ * caller (e.g. a pitch), and only voices that are on are rendered. A voice
+ * returns to the free stack once its envelope has finished.
+ *
+ * @tparam V Voice type
+ */
+template <typename V = Voice>
+class VoicePool
+{
+public:
+    explicit VoicePool(const V& voice, size_t size, VoiceStealing stealing = VoiceStealing::Oldest)
+    : m_voices{}
+    , m_slots(size)
+    , m_free{}
+    , m_active{}
+    , m_age{0}
+    , m_stealing{stealing}
+    {
+        m_voices.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_voices.push_back(Util::clone<V>(voice));
+        }
+
+        reset_lists();
+    }
+
+    ~VoicePool() noexcept = default;
+
+    VoicePool(const VoicePool& other)
+    : m_voices{}
+    , m_slots{other.m_slots}
+    , m_free{}
+    , m_active{}
+    , m_age{other.m_age}
+    , m_stealing{other.m_stealing}
+    {
+        m_voices.reserve(other.m_voices.size());
+        for (const auto& v : other.m_voices)
+        {
+            m_voices.push_back(Util::clone<V>(*v));
+        }
+
+        m_free.reserve(m_voices.size());
+        m_active.reserve(m_voices.size());
+        m_free = other.m_free;
+        m_active = other.m_active;
+    }
+
+    VoicePool& operator=(const VoicePool& other)
+    {
+        if (this != &other)
+        {
+            *this = VoicePool(other);
+        }
+        return *this;
+    }
+
+    VoicePool(VoicePool&&) noexcept = default;
+    VoicePool& operator=(VoicePool&&) noexcept = default;
+
+    size_t size() const
+    {
+        return m_voices.size();
+    }
+
+    /**
+     * @brief The number of voices that are currently sounding.
+     */
+    size_t active() const
+    {
+        return m_active.size();
+    }
+
+    void stealing(VoiceStealing stealing)
+    {
+        m_stealing = stealing;
+    }
+
+    VoiceStealing stealing() const
+    {
+        return m_stealing;
+    }
+
+    /**
+     * @brief Start a note. A note that is already held by a voice restarts
+     * on the same voice. A frequency of 0 stops the note instead.
+     */
+    void note_on(unsigned int key, float freq)
+    {
+        if (freq == 0 || m_voices.empty())
+        {
+            note_off(key);
+            return;
+        }
+
+        size_t index = find(key);
+        if (index == m_voices.size())
+        {
+            index = allocate();
+        }
+
+        Slot& slot = m_slots[index];
+        slot.key = key;
+        slot.age = ++m_age;
+        slot.is_held = true;
+
+        m_voices[index]->note_on(freq);
+    }
+
+    /**
+     * @brief Release the voice holding the given note. The voice keeps
+     * sounding until its envelope finishes.
+     */
+    void note_off(unsigned int key)
+    {
+        size_t index = find(key);
+        if (index != m_voices.size())
+        {
+            m_slots[index].is_held = false;
+            m_voices[index]->note_off();
+        }
+    }
+
+    /**
+     * @brief Release all voices.
+     */
+    void note_off()
+    {
+        for (size_t index : m_active)
+        {
+            m_slots[index].is_held = false;
+            m_voices[index]->note_off();
+        }
+    }
+
+    template <typename V2 = V>
+    V2& voice(size_t index)
+    {
+        return static_cast<V2&>(*m_voices[index]);
+    }
+
+    template <typename V2 = V>
+    const V2& voice(size_t index) const
+    {
+        return static_cast<const V2&>(*m_voices[index]);
+    }
+
+    /**
+     * @brief Call a method on every voice in the pool, e.g. to change a
+     * parameter of the whole instrument.
+     */
+    template <typename V2 = V, typename F, typename... Args>
+    void call_all_voices(F func, Args&&... args)
+    {
+        for (auto& v : m_voices)
+        {
+            std::invoke(func, static_cast<V2&>(*v), args...);
+        }
+    }
+
+    void process(float sample_duration, float& out)
+    {
+        out = 0;
+        for (size_t index : m_active)
+        {
+            float temp;
+            m_voices[index]->process(sample_duration, temp);
+            out += temp;
+
+            m_slots[index].peak = std::abs(temp);
+        }
+
+        free_finished();
+    }
+
+    void process_block(float sample_duration, float* out, size_t frames)
+    {
+        float temp[Util::block_size_max];
+
+        std::fill(out, out + frames, 0.0f);
+        for (size_t index : m_active)
+        {
+            float peak = 0;
+
+            for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+            {
+                size_t chunk = std::min(frames - offset, Util::block_size_max);
+
+                m_voices[index]->process_block(sample_duration, temp, chunk);
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    out[offset + i] += temp[i];
+                    peak = std::max(peak, std::abs(temp[i]));
+                }
+            }
+
+            m_slots[index].peak = peak;
+        }
+
+        free_finished();
+    }
+
+private:
+    struct Slot
+    {
+        unsigned int key = 0;
+        unsigned long age = 0;
+
+        // The peak of the voice's last rendered block.
+        float peak = 0;
+
+        bool is_held = false;
+    };
+
+    void reset_lists()
+    {
+        m_free.clear();
+        m_active.clear();
+        m_free.reserve(m_voices.size());
+        m_active.reserve(m_voices.size());
+
+        // Hand out the voices in order.
+        for (size_t i = m_voices.size(); i > 0; --i)
+        {
+            m_free.push_back(i - 1);
+        }
+    }
+
+    // The voice holding the given note, or size() if there's none.
+    size_t find(unsigned int key) const
+    {
+        for (size_t index : m_active)
+        {
+            if (m_slots[index].is_held && m_slots[index].key == key)
+            {
+                return index;
+            }
+        }
+
+        return m_voices.size();
+    }
+
+    // Take a free voice, or steal a sounding one.
+    size_t allocate()
+    {
+        if (!m_free.empty())
+        {
+            size_t index = m_free.back();
+            m_free.pop_back();
+            m_active.push_back(index);
+            return index;
+        }
+
+        auto is_better_victim = [this](size_t a, size_t b)
+        {
+            const Slot& sa = m_slots[a];
+            const Slot& sb = m_slots[b];
+
+            if (sa.is_held != sb.is_held)
+            {
+                return !sa.is_held;
+            }
+
+            if (m_stealing == VoiceStealing::Quietest && sa.peak != sb.peak)
+            {
+                return sa.peak < sb.peak;
+            }
+
+            return sa.age < sb.age;
+        };
+
+        return *std::min_element(m_active.begin(), m_active.end(), is_better_victim);
+    }
+
+    // Return the voices whose envelopes have finished to the free stack.
+    void free_finished()
+    {
+        for (size_t i = 0; i < m_active.size();)
+        {
+            size_t index = m_active[i];
+
+            if (m_voices[index]->is_on())
+            {
+                ++i;
+                continue;
+            }
+
+            m_slots[index].is_held = false;
+            m_free.push_back(index);
+            m_active[i] = m_active.back();
+            m_active.pop_back();
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<V>> m_voices;
+    std::vector<Slot> m_slots;
+
+    // Both have the capacity for every voice, so they never reallocate.
+    std::vector<size_t> m_free;
+    std::vector<size_t> m_active;
+
+    unsigned long m_age;
+    VoiceStealing m_stealing;
+};
+
+/**
+ * @brief A polyphonic instrument, playing each note on a voice from a
+ * VoicePool. The index parameters of note_on() and note_off() are the keys
+ * that identify notes.
+ *
+ * @tparam V Voice type
+ * @tparam O Output type (OutputMono or OutputStereo)
+ */
+template <typename V = Voice, typename O = OutputStereo>
+class InstrumentPoly;
+
+template <typename V>
+class InstrumentPoly<V, OutputMono> : public Device<InputNone, OutputMono>
+{
+public:
+    explicit InstrumentPoly(V& voice, size_t voices, float vol = 1, VoiceStealing stealing = VoiceStealing::Oldest)
+    : m_pool{voice, voices, stealing}
+    , m_vol{vol}
+    {
+    }
+
+    ~InstrumentPoly() noexcept = default;
+
+    InstrumentPoly(const InstrumentPoly&) = default;
+    InstrumentPoly& operator=(const InstrumentPoly&) = default;
+    InstrumentPoly(InstrumentPoly&&) noexcept = default;
+    InstrumentPoly& operator=(InstrumentPoly&&) noexcept = default;
+
+    std::unique_ptr<Device> clone() const override
+    {
+        return std::make_unique<InstrumentPoly<V, OutputMono>>(*this);
+    }
+
+    void note_on(unsigned int index, float freq)
+    {
+        m_pool.note_on(index, freq);
+    }
+
+    void note_off(unsigned int index)
+    {
+        m_pool.note_off(index);
+    }
+
+    void note_off()
+    {
+        m_pool.note_off();
+    }
+
+    void vol(float vol) override
+    {
+        m_vol = vol;
+    }
+
+    float vol() const override
+    {
+        return m_vol;
+    }
+
+    bool is_idle() const override
+    {
+        return m_pool.active() == 0;
+    }
+
+    VoicePool<V>& pool()
+    {
+        return m_pool;
+    }
+
+    const VoicePool<V>& pool() const
+    {
+        return m_pool;
+    }
+
+    template <typename V2 = V>
+    V2& voice(unsigned int index)
+    {
+        return m_pool.template voice<V2>(index);
+    }
+
+    template <typename V2 = V, typename F, typename... Args>
+    void call_all_voices(F func, Args&&... args)
+    {
+        m_pool.template call_all_voices<V2>(func, std::forward<Args>(args)...);
+    }
+
+    void process(float sample_duration, float& out) override
+    {
+        m_pool.process(sample_duration, out);
+        out *= m_vol;
+    }
+
+    void process_block(float sample_duration, float* out, size_t frames) override
+    {
+        m_pool.process_block(sample_duration, out, frames);
+
+        for (size_t i = 0; i < frames; ++i)
+        {
+            out[i] *= m_vol;
+        }
+    }
+
+private:
+    VoicePool<V> m_pool;
+    float m_vol;
+};
+
+template <typename V>
+class InstrumentPoly<V, OutputStereo> : public Device<InputNone, OutputStereo>
+{
+public:
+    explicit InstrumentPoly(V& voice, size_t voices, float vol = 1, float pan = .5,
+        VoiceStealing stealing = VoiceStealing::Oldest)
+    : m_pool{voice, voices, stealing}
+    , m_vol{vol}
+    , m_pan{pan}
+    {
+    }
+
+    ~InstrumentPoly() noexcept = default;
+
+    InstrumentPoly(const InstrumentPoly&) = default;
+    InstrumentPoly& operator=(const InstrumentPoly&) = default;
+    InstrumentPoly(InstrumentPoly&&) noexcept = default;
+    InstrumentPoly& operator=(InstrumentPoly&&) noexcept = default;
+
+    std::unique_ptr<Device> clone() const override
+    {
+        return std::make_unique<InstrumentPoly<V, OutputStereo>>(*this);
+    }
+
+    void note_on(unsigned int index, float freq)
+    {
+        m_pool.note_on(index, freq);
+    }
+
+    void note_off(unsigned int index)
+    {
+        m_pool.note_off(index);
+    }
+
+    void note_off()
+    {
+        m_pool.note_off();
+    }
+
+    void vol(float vol) override
+    {
+        m_vol = vol;
+    }
+
+    float vol() const override
+    {
+        return m_vol;
+    }
+
+    void pan(float pan) override
+    {
+        m_pan = pan;
+    }
+
+    float pan() const override
+    {
+        return m_pan;
+    }
+
+    bool is_idle() const override
+    {
+        return m_pool.active() == 0;
+    }
+
+    VoicePool<V>& pool()
+    {
+        return m_pool;
+    }
+
+    const VoicePool<V>& pool() const
+    {
+        return m_pool;
+    }
+
+    template <typename V2 = V>
+    V2& voice(unsigned int index)
+    {
+        return m_pool.template voice<V2>(index);
+    }
+
+    template <typename V2 = V, typename F, typename... Args>
+    void call_all_voices(F func, Args&&... args)
+    {
+        m_pool.template call_all_voices<V2>(func, std::forward<Args>(args)...);
+    }
+
+    void process(float sample_duration, float& out_left, float& out_right) override
+    {
+        float out;
+        m_pool.process(sample_duration, out);
+        out *= m_vol;
+
+        // Pan
+        out_right = out * m_pan;
+        out_left = out * (1 - m_pan);
+    }
+
+    void process_block(float sample_duration, float* out_left, float* out_right, size_t frames) override
+    {
+        m_pool.process_block(sample_duration, out_left, frames);
+
+        for (size_t i = 0; i < frames; ++i)
+        {
+            float out = m_vol * out_left[i];
+
+            // Pan
+            out_right[i] = out * m_pan;
+            out_left[i] = out * (1 - m_pan);
+        }
+    }
+
+private:
+    VoicePool<V> m_pool;
+    float m_vol;
+    float m_pan;
+};
+
 }
 
 #endif // INSTRUMENT_H_
\ No newline at end of file
@@ -3,7 +3,10 @@
 
 #include "device.hpp"
 #include "util.hpp"
+#include "worker_pool.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 #include <memory>
 
@@ -12,6 +15,12 @@ namespace MusicLib {
 /**
  * @brief A simple device manager that holds only instruments of a given type.
  * 
+ * Only awake instruments are rendered. An instrument is woken whenever it's
+ * accessed for modification through instrument(), and is put to sleep once
+ * it reports being idle after rendering, so silent instruments cost nothing.
+ * Idleness is checked after every block, or every Util::block_size_max
+ * samples when rendering sample by sample.
+ * 
  * @tparam I an implementation of the Instrument interface
  */
 template <typename I = Device<InputNone, OutputStereo>>
@@ -20,12 +29,18 @@ class InstrumentManager : public Device<InputNone, OutputStereo>
 public:
     explicit InstrumentManager()
     : m_instruments{}
+    , m_active{}
+    , m_is_active{}
+    , m_samples_since_sleep{}
     {}
 
     ~InstrumentManager() noexcept = default;
     
     InstrumentManager(const InstrumentManager& other)
     : m_instruments{}
+    , m_active{}
+    , m_is_active{}
+    , m_samples_since_sleep{}
     {
         m_instruments.reserve(other.m_instruments.size());
 
@@ -33,6 +48,11 @@ public:
         {
             m_instruments.push_back(Util::clone<I>(*ins));
         }
+
+        m_active.reserve(m_instruments.size());
+        m_active.assign(other.m_active.begin(), other.m_active.end());
+        m_is_active = other.m_is_active;
+        m_samples_since_sleep = other.m_samples_since_sleep;
     }
 
     InstrumentManager& operator=(const InstrumentManager& other)
@@ -44,6 +64,11 @@ public:
             {
                 m_instruments.push_back(Util::clone<I>(*ins));
             }
+
+            m_active.reserve(m_instruments.size());
+            m_active.assign(other.m_active.begin(), other.m_active.end());
+            m_is_active = other.m_is_active;
+            m_samples_since_sleep = other.m_samples_since_sleep;
         }
         return *this;
     }
@@ -53,18 +78,53 @@ public:
 
     /**
      * @brief Return a reference to the numbered instrument. If a template
-     * parameter is given, the instrument is casted to it.
+     * parameter is given, the instrument is casted to it. The instrument is
+     * woken, since it may be about to play a note.
      * 
      * @tparam I2 return Instrument type
      * @param index 
      * @return I2& 
      */
     template <typename I2 = I>
-    I2& instrument(unsigned int index) const
+    I2& instrument(unsigned int index)
     {
+        wake(index);
         return static_cast<I2&>(*m_instruments[index]); 
     }
 
+    template <typename I2 = I>
+    const I2& instrument(unsigned int index) const
+    {
+        return static_cast<const I2&>(*m_instruments[index]); 
+    }
+
+    /**
+     * @brief Make sure the numbered instrument is rendered at least once
+     * more. Needed only when an instrument is modified without going
+     * through instrument(), e.g. through a reference kept from before.
+     */
+    void wake(unsigned int index)
+    {
+        if (m_is_active[index])
+        {
+            return;
+        }
+
+        // Keep the list sorted, so instruments are mixed in the same order
+        // whether or not others are asleep. It never reallocates, since
+        // its capacity is the number of instruments.
+        m_active.insert(std::upper_bound(m_active.begin(), m_active.end(), index), index);
+        m_is_active[index] = true;
+    }
+
+    /**
+     * @brief Number of instruments currently being rendered.
+     */
+    size_t active() const
+    {
+        return m_active.size();
+    }
+
     std::unique_ptr<Device> clone() const
     {
         return std::make_unique<InstrumentManager<I>>(*this);
@@ -73,6 +133,11 @@ public:
     void clone_instrument(I& instrument)
     {
         m_instruments.push_back(Util::clone<I>(instrument));
+
+        // New instruments start awake, in case they're already playing.
+        m_active.reserve(m_instruments.size());
+        m_is_active.push_back(false);
+        wake(m_instruments.size() - 1);
     }
 
     void vol(float vol) override
@@ -102,20 +167,198 @@ public:
 
         out_left = 0;
         out_right = 0;
-        for (auto& ins : m_instruments)
+        for (size_t index : m_active)
         {
-            ins->process(sample_duration, temp_left, temp_right);
+            m_instruments[index]->process(sample_duration, temp_left, temp_right);
             out_left += temp_left;
             out_right += temp_right;
         }
+
+        // Checking every instrument for idleness costs about as much as
+        // rendering a sample, so it's done once per block's worth.
+        if (++m_samples_since_sleep >= Util::block_size_max)
+        {
+            sleep_idle();
+        }
     }
 
-private:
+    void process_block(float sample_duration, float* out_left, float* out_right, size_t frames) override
+    {
+        float temp_left[Util::block_size_max];
+        float temp_right[Util::block_size_max];
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+            float* left = out_left + offset;
+            float* right = out_right + offset;
+
+            std::fill(left, left + chunk, 0.0f);
+            std::fill(right, right + chunk, 0.0f);
+            for (size_t index : m_active)
+            {
+                m_instruments[index]->process_block(sample_duration, temp_left, temp_right, chunk);
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    left[i] += temp_left[i];
+                    right[i] += temp_right[i];
+                }
+            }
+
+            sleep_idle();
+        }
+    }
+
+protected:
+    /**
+     * @brief Remove the instruments that have gone idle from the active
+     * list. An idle instrument would only have added zeros to the mix.
+     */
+    void sleep_idle()
+    {
+        m_samples_since_sleep = 0;
+
+        auto is_idle = [this](size_t index)
+        {
+            if (!m_instruments[index]->is_idle())
+            {
+                return false;
+            }
+
+            m_is_active[index] = false;
+            return true;
+        };
+
+        m_active.erase(std::remove_if(m_active.begin(), m_active.end(), is_idle), m_active.end());
+    }
+
+protected:
     std::vector<std::unique_ptr<I>> m_instruments;
+
+    // Indices of the awake instruments, in ascending order.
+    std::vector<size_t> m_active;
+    std::vector<bool> m_is_active;
+
+    // Samples rendered by process() since the last call to sleep_idle().
+    size_t m_samples_since_sleep;
+
+private:
     float m_vol;
     float m_pan;
 };
 
+/**
+ * @brief An instrument manager that renders its instruments in parallel on a
+ * persistent worker pool.
+ * 
+ * Every instrument renders into its own cache-line-aligned buffer, and the
+ * buffers are mixed in instrument order on the calling thread, so the output
+ * is bit-identical to InstrumentManager's regardless of the number of
+ * threads. Like there, idle instruments are skipped.
+ * 
+ * @tparam I an implementation of the Instrument interface
+ */
+template <typename I = Device<InputNone, OutputStereo>>
+class InstrumentManagerParallel : public InstrumentManager<I>
+{
+public:
+    /**
+     * @param threads Number of worker threads, in addition to the audio
+     * thread.
+     * @param pin Pin each worker to its own CPU core.
+     */
+    explicit InstrumentManagerParallel(unsigned int threads, bool pin = true)
+    : InstrumentManager<I>{}
+    , m_pool{std::make_unique<WorkerPool>(threads, pin)}
+    , m_buffers{}
+    {}
+
+    ~InstrumentManagerParallel() noexcept = default;
+
+    InstrumentManagerParallel(const InstrumentManagerParallel& other)
+    : InstrumentManager<I>{other}
+    , m_pool{std::make_unique<WorkerPool>(other.m_pool->threads(), other.m_pool->pinned())}
+    , m_buffers(this->m_instruments.size())
+    {}
+
+    InstrumentManagerParallel& operator=(const InstrumentManagerParallel& other)
+    {
+        if (this != &other)
+        {
+            InstrumentManager<I>::operator=(other);
+            m_pool = std::make_unique<WorkerPool>(other.m_pool->threads(), other.m_pool->pinned());
+            m_buffers = std::vector<Buffer>(this->m_instruments.size());
+        }
+        return *this;
+    }
+
+    InstrumentManagerParallel(InstrumentManagerParallel&&) noexcept = default;
+    InstrumentManagerParallel& operator=(InstrumentManagerParallel&&) noexcept = default;
+
+    std::unique_ptr<Device<InputNone, OutputStereo>> clone() const override
+    {
+        return std::make_unique<InstrumentManagerParallel<I>>(*this);
+    }
+
+    void clone_instrument(I& instrument)
+    {
+        InstrumentManager<I>::clone_instrument(instrument);
+        m_buffers.resize(this->m_instruments.size());
+    }
+
+    void process_block(float sample_duration, float* out_left, float* out_right, size_t frames) override
+    {
+        auto& instruments = this->m_instruments;
+        auto& active = this->m_active;
+
+        // Instruments added through the base class have no buffer, and
+        // allocating one here would block the audio thread.
+        if (m_buffers.size() < instruments.size())
+        {
+            InstrumentManager<I>::process_block(sample_duration, out_left, out_right, frames);
+            return;
+        }
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+            float* left = out_left + offset;
+            float* right = out_right + offset;
+
+            auto render = [&](size_t n)
+            {
+                size_t index = active[n];
+                instruments[index]->process_block(sample_duration,
+                    m_buffers[index].left, m_buffers[index].right, chunk);
+            };
+            m_pool->run(render, active.size());
+
+            std::fill(left, left + chunk, 0.0f);
+            std::fill(right, right + chunk, 0.0f);
+            for (size_t index : active)
+            {
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    left[i] += m_buffers[index].left[i];
+                    right[i] += m_buffers[index].right[i];
+                }
+            }
+
+            this->sleep_idle();
+        }
+    }
+
+private:
+    struct alignas(Util::cache_line_size) Buffer
+    {
+        float left[Util::block_size_max];
+        float right[Util::block_size_max];
+    };
+
+    std::unique_ptr<WorkerPool> m_pool;
+    std::vector<Buffer> m_buffers;
+};
+
 }
 
 #endif // INSTRUMENT_MANAGER_H_
\ No newline at end of file
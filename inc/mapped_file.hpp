@@ -0,0 +1,51 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace MusicLib {
+
+/**
+ * @brief A whole file, mapped read-only into memory. Its pages are loaded on
+ * first access, so opening a file takes the same time regardless of its
+ * size.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Map a file. Throws std::runtime_error if it can't be opened or
+     * mapped. An empty file is mapped as an empty range.
+     *
+     * @param sequential Hint that the file will be read once from start to
+     * end, so pages can be read ahead aggressively and dropped early.
+     */
+    explicit MappedFile(const std::string& filename, bool sequential = false);
+    ~MappedFile() noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const std::byte* data() const;
+    size_t size() const;
+
+    /**
+     * @brief The file's contents as text.
+     */
+    std::string_view text() const;
+
+private:
+    void unmap();
+
+private:
+    const std::byte* m_data;
+    size_t m_size;
+};
+
+}
+
+#endif // MAPPED_FILE_H_
@@ -3,10 +3,13 @@
 
 #include "util.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 namespace MusicLib {
 
@@ -14,6 +17,33 @@ namespace MusicLib {
 float osc_saw(float phase);
 float osc_square(float phase);
 float osc_triangle(float phase);
+float osc_pulse(float phase, float pulsewidth);
+float osc_wavetable(float phase, const float* wavetable, size_t size, bool antialiasing);
+
+// Interpolation between the points of a wavetable.
+enum class Interpolation
+{
+    None,
+    Linear,
+    Cubic
+};
+
+// Look up a table whose size is a power of two, and which is padded with
+// one guard point before it and two after it (the last point, and the first
+// two points), so that lookups wrap with a mask instead of a modulo.
+float osc_table(float phase, const float* table, size_t size, Interpolation interpolation);
+
+// Batch versions of the oscillator functions, evaluated at n phases at once.
+// Vectorized with SSE2, or AVX2 when the CPU supports it, and equal to the
+// scalar functions sample for sample.
+void osc_saw_values(const float* phases, float* out, size_t n);
+void osc_square_values(const float* phases, float* out, size_t n);
+void osc_triangle_values(const float* phases, float* out, size_t n);
+void osc_pulse_values(const float* phases, float* out, size_t n, float pulsewidth);
+void osc_wavetable_values(const float* phases, float* out, size_t n,
+    const float* wavetable, size_t size, bool antialiasing);
+void osc_table_values(const float* phases, float* out, size_t n,
+    const float* table, size_t size, Interpolation interpolation);
 
 /**
  * @brief An oscillator interface. Used by the VoiceOsc class as the first
@@ -36,6 +66,212 @@ public:
      * @return A sample. 
      */
     virtual float value(float phase) const = 0;
+
+    /**
+     * @brief Give the value of the oscillator at the given phase, when the
+     * phase advances by phase_increment every sample. Band-limited
+     * oscillators need the increment to know how wide a transition can be
+     * without aliasing; the rest ignore it and return value(phase).
+     */
+    virtual float value_with_increment(float phase, float phase_increment [[maybe_unused]]) const
+    {
+        return value(phase);
+    }
+
+    /**
+     * @brief Give the values of the oscillator at n phases. Falls back to
+     * calling value() once per phase.
+     */
+    virtual void values(const float* phases, float* out, size_t n) const
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = value(phases[i]);
+        }
+    }
+
+    /**
+     * @brief Fill a block with the oscillator's values along a phase ramp.
+     * The phase is propagated the same way VoiceOsc does, and the values
+     * are computed with values().
+     * 
+     * @param phase The phase of the first sample.
+     * @param phase_increment The phase difference between consecutive samples.
+     * @param out 
+     * @param frames 
+     * @return The phase that follows the last sample of the block.
+     */
+    virtual float process_block(float phase, float phase_increment, float* out, size_t frames) const
+    {
+        return render_block(*this, phase, phase_increment, out, frames);
+    }
+
+    /**
+     * @brief Like process_block(), but with a phase increment per sample, for
+     * a modulated pitch.
+     * 
+     * @param phase_increments The phase difference between each sample and
+     * the next.
+     */
+    virtual float process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const
+    {
+        return render_block_modulated(*this, phase, phase_increments, out, frames);
+    }
+
+    /**
+     * @brief Call osc.value_with_increment() bound statically to O, for
+     * callers that hold an O by value and so know its dynamic type, like
+     * VoiceStatic. If O doesn't override it, O's value() is called.
+     */
+    template <typename O>
+    static float static_value_with_increment(const O& osc, float phase, float phase_increment)
+    {
+        if constexpr (std::is_same_v<decltype(&O::value_with_increment), decltype(&Oscillator::value_with_increment)>)
+        {
+            return osc.O::value(phase);
+        }
+        else
+        {
+            return osc.O::value_with_increment(phase, phase_increment);
+        }
+    }
+
+    /**
+     * @brief Call osc.process_block() bound statically to O, like
+     * static_value_with_increment(). If O doesn't override it, the default
+     * is run with O's values().
+     */
+    template <typename O>
+    static float static_process_block(const O& osc, float phase, float phase_increment, float* out, size_t frames)
+    {
+        if constexpr (std::is_same_v<decltype(&O::process_block), decltype(&Oscillator::process_block)>)
+        {
+            return render_block(osc, phase, phase_increment, out, frames);
+        }
+        else
+        {
+            return osc.O::process_block(phase, phase_increment, out, frames);
+        }
+    }
+
+    /**
+     * @brief Call osc.process_block_modulated() bound statically to O, as
+     * static_process_block().
+     */
+    template <typename O>
+    static float static_process_block_modulated(const O& osc, float phase, const float* phase_increments, float* out, size_t frames)
+    {
+        if constexpr (std::is_same_v<decltype(&O::process_block_modulated), decltype(&Oscillator::process_block_modulated)>)
+        {
+            return render_block_modulated(osc, phase, phase_increments, out, frames);
+        }
+        else
+        {
+            return osc.O::process_block_modulated(phase, phase_increments, out, frames);
+        }
+    }
+
+protected:
+    /**
+     * @brief The default process_block(), calling osc.values(). When O is a
+     * derived class, the call is bound statically to it.
+     */
+    template <typename O>
+    static float render_block(const O& osc, float phase, float phase_increment, float* out, size_t frames)
+    {
+        float phases[Util::block_size_max];
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+
+            phase = phase_ramp(phase, phase_increment, phases, chunk);
+            static_values(osc, phases, out + offset, chunk);
+        }
+
+        return phase;
+    }
+
+    /**
+     * @brief The default process_block_modulated(), as render_block().
+     */
+    template <typename O>
+    static float render_block_modulated(const O& osc, float phase, const float* phase_increments, float* out, size_t frames)
+    {
+        float phases[Util::block_size_max];
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+
+            phase = phase_ramp(phase, phase_increments + offset, phases, chunk);
+            static_values(osc, phases, out + offset, chunk);
+        }
+
+        return phase;
+    }
+
+    /**
+     * @brief Call osc.values(), bound statically to O unless it's Oscillator
+     * itself. If O doesn't override it, O's value() is called per phase.
+     */
+    template <typename O>
+    static void static_values(const O& osc, const float* phases, float* out, size_t n)
+    {
+        if constexpr (std::is_same_v<O, Oscillator>)
+        {
+            osc.values(phases, out, n);
+        }
+        else if constexpr (std::is_same_v<decltype(&O::values), decltype(&Oscillator::values)>)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                out[i] = osc.O::value(phases[i]);
+            }
+        }
+        else
+        {
+            osc.O::values(phases, out, n);
+        }
+    }
+
+    /**
+     * @brief Fill phases with n phases starting at the given one, propagated
+     * the same way VoiceOsc does.
+     * 
+     * @return The phase that follows the last one.
+     */
+    static float phase_ramp(float phase, float phase_increment, float* phases, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            phases[i] = phase;
+
+            phase += phase_increment;
+            if (phase >= 1)
+            {
+                phase -= 1;
+            }
+        }
+
+        return phase;
+    }
+
+    static float phase_ramp(float phase, const float* phase_increments, float* phases, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            phases[i] = phase;
+
+            phase += phase_increments[i];
+            if (phase >= 1)
+            {
+                phase -= 1;
+            }
+        }
+
+        return phase;
+    }
 };
 
 /**
@@ -102,6 +338,26 @@ public:
         return m_oscs[m_osc_index]->value(phase);
     }
 
+    float value_with_increment(float phase, float phase_increment) const override
+    {
+        return m_oscs[m_osc_index]->value_with_increment(phase, phase_increment);
+    }
+
+    void values(const float* phases, float* out, size_t n) const override
+    {
+        m_oscs[m_osc_index]->values(phases, out, n);
+    }
+
+    float process_block(float phase, float phase_increment, float* out, size_t frames) const override
+    {
+        return m_oscs[m_osc_index]->process_block(phase, phase_increment, out, frames);
+    }
+
+    float process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const override
+    {
+        return m_oscs[m_osc_index]->process_block_modulated(phase, phase_increments, out, frames);
+    }
+
     void add_osc(Oscillator& osc)
     {
         m_oscs.emplace_back(Util::clone<O>(osc));
@@ -137,9 +393,14 @@ public:
     std::unique_ptr<Oscillator> clone() const override;
 
     float value(float phase) const override;
+    void values(const float* phases, float* out, size_t n) const override;
 
 private:
     std::function<float(float)> m_osc_func;
+
+    // The batch version of m_osc_func if it's one of the basic oscillator
+    // functions, otherwise null.
+    void (*m_osc_values)(const float*, float*, size_t);
 };
 
 /**
@@ -154,6 +415,7 @@ public:
     std::unique_ptr<Oscillator> clone() const override;
 
     float value(float phase) const override;
+    void values(const float* phases, float* out, size_t n) const override;
 
     void pulsewidth(float pulsewidth);
     float pulsewidth() const;        
@@ -174,11 +436,136 @@ public:
     std::unique_ptr<Oscillator> clone() const override;
 
     float value(float phase) const override;
+    void values(const float* phases, float* out, size_t n) const override;
 
 private:
     std::vector<float> m_wavetable;
     bool m_antialiasing;
 };
 
+/**
+ * @brief A band-limited oscillator, using PolyBLEP to smooth the steps of the
+ * saw, square and pulse waves, and PolyBLAMP to smooth the corners of the
+ * triangle wave. Follows the same waveshapes as osc_saw, osc_square,
+ * osc_triangle and OscillatorPulse, but with much less aliasing.
+ *
+ * The correction depends on the phase increment, so value() alone gives the
+ * naive waveshape. VoiceOsc passes the increment through
+ * value_with_increment() and process_block().
+ */
+class OscillatorPolyBLEP : public Oscillator
+{
+public:
+    enum class Shape
+    {
+        Saw,
+        Square,
+        Triangle,
+        Pulse
+    };
+
+public:
+    explicit OscillatorPolyBLEP(Shape shape = Shape::Saw, float pulsewidth = .5);
+    ~OscillatorPolyBLEP() noexcept = default;
+
+    std::unique_ptr<Oscillator> clone() const override;
+
+    float value(float phase) const override;
+    float value_with_increment(float phase, float phase_increment) const override;
+    float process_block(float phase, float phase_increment, float* out, size_t frames) const override;
+    float process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const override;
+
+    void shape(Shape shape);
+    Shape shape() const;
+
+    void pulsewidth(float pulsewidth);
+    float pulsewidth() const;
+
+private:
+    template <Shape S>
+    float render(float phase, float phase_increment, float* out, size_t frames) const;
+
+    template <Shape S>
+    float render_modulated(float phase, const float* phase_increments, float* out, size_t frames) const;
+
+private:
+    Shape m_shape;
+    float m_pulsewidth;
+};
+
+/**
+ * @brief A wavetable oscillator with band-limited copies of the table, one
+ * per octave, so that high notes don't alias.
+ *
+ * The source table is resampled to a power-of-two length, and each level is
+ * built from its spectrum with the harmonics that fit under the Nyquist
+ * frequency an octave higher than the previous level. The level is selected
+ * by the phase increment, and optionally crossfaded with the next one along
+ * the octave, so that sweeping the pitch doesn't switch levels audibly. Each
+ * level is padded with guard points, so that lookups wrap with a mask
+ * instead of a modulo.
+ *
+ * Like OscillatorPolyBLEP, value() alone doesn't know the pitch, and reads
+ * the full-bandwidth level.
+ */
+class OscillatorWavetableMipmap : public Oscillator
+{
+public:
+    explicit OscillatorWavetableMipmap(const std::vector<float>& wavetable,
+        Interpolation interpolation = Interpolation::Linear, bool crossfade = true);
+    ~OscillatorWavetableMipmap() noexcept = default;
+
+    std::unique_ptr<Oscillator> clone() const override;
+
+    float value(float phase) const override;
+    float value_with_increment(float phase, float phase_increment) const override;
+    void values(const float* phases, float* out, size_t n) const override;
+    float process_block(float phase, float phase_increment, float* out, size_t frames) const override;
+
+    /**
+     * @brief Like process_block(), but the levels are selected by the
+     * largest phase increment of each chunk, so that no sample aliases.
+     */
+    float process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const override;
+
+    /**
+     * @brief Give the values of the oscillator at n phases, reading the
+     * levels that fit the given phase increment.
+     */
+    void values_with_increment(const float* phases, float* out, size_t n, float phase_increment) const;
+
+    void interpolation(Interpolation interpolation);
+    Interpolation interpolation() const;
+
+    void crossfade(bool crossfade);
+    bool crossfade() const;
+
+    /**
+     * @brief The length of each level, a power of two.
+     */
+    size_t size() const;
+    size_t levels() const;
+
+private:
+    // Guard points before and after each level.
+    static constexpr size_t guard_before = 1;
+    static constexpr size_t guard_after = 2;
+
+    const float* level(size_t index) const;
+
+    /**
+     * @brief Give the index of the level to play at the given phase
+     * increment, and the position of the crossfade into the next level.
+     */
+    size_t select_level(float phase_increment, float& position) const;
+
+private:
+    std::vector<float> m_tables;
+    size_t m_size;
+    size_t m_levels;
+    Interpolation m_interpolation;
+    bool m_crossfade;
+};
+
 }
 #endif // OSC_H_
\ No newline at end of file
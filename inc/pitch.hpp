@@ -1,12 +1,14 @@
 #ifndef PITCH_H_
 #define PITCH_H_
 
-namespace MusicLib {
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 
-// Frequency table - generated with the Python line:
-//    print(', '.join([f"{440 * 2**((n - 69)/12):.5f}" for n in range(128)]))
-float freq_from_pitch[] = {8.17580, 8.66196, 9.17702, 9.72272, 10.30086, 10.91338, 11.56233, 12.24986, 12.97827, 13.75000, 14.56762, 15.43385, 16.35160, 17.32391, 18.35405, 19.44544, 20.60172, 21.82676, 23.12465, 24.49971, 25.95654, 27.50000, 29.13524, 30.86771, 32.70320, 34.64783, 36.70810, 38.89087, 41.20344, 43.65353, 46.24930, 48.99943, 51.91309, 55.00000, 58.27047, 61.73541, 65.40639, 69.29566, 73.41619, 77.78175, 82.40689, 87.30706, 92.49861, 97.99886, 103.82617, 110.00000, 116.54094, 123.47083, 130.81278, 138.59132, 146.83238, 155.56349, 164.81378, 174.61412, 184.99721, 195.99772, 207.65235, 220.00000, 233.08188, 246.94165, 261.62557, 277.18263, 293.66477, 311.12698, 329.62756, 349.22823, 369.99442, 391.99544, 415.30470, 440.00000, 466.16376, 493.88330, 523.25113, 554.36526, 587.32954, 622.25397, 659.25511, 698.45646, 739.98885, 783.99087, 830.60940, 880.00000, 932.32752, 987.76660, 1046.50226, 1108.73052, 1174.65907, 1244.50793, 1318.51023, 1396.91293, 1479.97769, 1567.98174, 1661.21879, 1760.00000, 1864.65505, 1975.53321, 2093.00452, 2217.46105, 2349.31814, 2489.01587, 2637.02046, 2793.82585, 2959.95538, 3135.96349, 3322.43758, 3520.00000, 3729.31009, 3951.06641, 4186.00904, 4434.92210, 4698.63629, 4978.03174, 5274.04091, 5587.65170, 5919.91076, 6271.92698, 6644.87516, 7040.00000, 7458.62018, 7902.13282, 8372.01809, 8869.84419, 9397.27257, 9956.06348, 10548.08182, 11175.30341, 11839.82153, 12543.85395
-};
+namespace MusicLib {
 
 /**
  * @brief An interface class for representing musical pitch.
@@ -75,7 +77,7 @@ public:
         C = 0,
         D = 2,
         E = 4,
-        F = 6,
+        F = 5,
         G = 7,
         A = 9,
         B = 11
@@ -106,6 +108,196 @@ private:
     int m_octave;
 };
 
+/**
+ * @brief The parts of a pitch name such as "C#4", "Bb3" or "Fx-1": a letter
+ * from A to G, an optional accidental (#, x, b or bb) and an octave, in which
+ * C4 is middle C.
+ */
+struct PitchName
+{
+    PitchDiatonic::Class pitch_class;
+    PitchDiatonic::Accidental acc;
+    int octave;
+
+    constexpr int midi_value() const
+    {
+        return (octave + 1) * 12 + (int) pitch_class + (int) acc;
+    }
+};
+
+/**
+ * @brief Split a pitch name into its parts, without allocating. Usable at
+ * compile time. Octaves too large for a MIDI value to be computed from them
+ * are rejected.
+ */
+constexpr std::optional<PitchName> parse_pitch_name(std::string_view str)
+{
+    constexpr int octave_max = std::numeric_limits<int>::max() / 12 - 2;
+    PitchName name{};
+    size_t i = 0;
+
+    if (str.empty())
+    {
+        return std::nullopt;
+    }
+
+    switch (str[i++])
+    {
+    case 'C':
+        name.pitch_class = PitchDiatonic::Class::C;
+        break;
+    case 'D':
+        name.pitch_class = PitchDiatonic::Class::D;
+        break;
+    case 'E':
+        name.pitch_class = PitchDiatonic::Class::E;
+        break;
+    case 'F':
+        name.pitch_class = PitchDiatonic::Class::F;
+        break;
+    case 'G':
+        name.pitch_class = PitchDiatonic::Class::G;
+        break;
+    case 'A':
+        name.pitch_class = PitchDiatonic::Class::A;
+        break;
+    case 'B':
+        name.pitch_class = PitchDiatonic::Class::B;
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    name.acc = PitchDiatonic::Accidental::Natural;
+    if (i < str.size() && str[i] == '#')
+    {
+        name.acc = PitchDiatonic::Accidental::Sharp;
+        ++i;
+    }
+    else if (i < str.size() && str[i] == 'x')
+    {
+        name.acc = PitchDiatonic::Accidental::DoubleSharp;
+        ++i;
+    }
+    else if (i < str.size() && str[i] == 'b')
+    {
+        name.acc = PitchDiatonic::Accidental::Flat;
+        ++i;
+
+        if (i < str.size() && str[i] == 'b')
+        {
+            name.acc = PitchDiatonic::Accidental::DoubleFlat;
+            ++i;
+        }
+    }
+
+    bool is_negative = i < str.size() && str[i] == '-';
+    if (is_negative)
+    {
+        ++i;
+    }
+
+    if (i == str.size())
+    {
+        return std::nullopt;
+    }
+
+    int octave = 0;
+    for (; i < str.size(); ++i)
+    {
+        if (str[i] < '0' || str[i] > '9')
+        {
+            return std::nullopt;
+        }
+
+        int digit = str[i] - '0';
+        if (octave > (octave_max - digit) / 10)
+        {
+            return std::nullopt;
+        }
+
+        octave = octave * 10 + digit;
+    }
+
+    name.octave = is_negative ? -octave : octave;
+    return name;
+}
+
+/**
+ * @brief The MIDI value of a pitch name, if it's valid and within the MIDI
+ * range of 0 (C-1) to 127 (G9). Usable at compile time.
+ */
+constexpr std::optional<unsigned int> midi_from_name(std::string_view str)
+{
+    auto name = parse_pitch_name(str);
+    if (!name.has_value())
+    {
+        return std::nullopt;
+    }
+
+    int midi_value = name->midi_value();
+    if (midi_value < 0 || midi_value > 127)
+    {
+        return std::nullopt;
+    }
+
+    return (unsigned int) midi_value;
+}
+
+/**
+ * @brief Convert an array of pitch names to MIDI values, as midi_from_name
+ * does. Stops at the first invalid name.
+ *
+ * @param midi_values Must be at least as long as names.
+ * @return The index of the first invalid name, or the number of names if
+ * they're all valid.
+ */
+constexpr size_t midi_from_names(std::span<const std::string_view> names, std::span<unsigned int> midi_values)
+{
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        auto midi_value = midi_from_name(names[i]);
+        if (!midi_value.has_value())
+        {
+            return i;
+        }
+
+        midi_values[i] = midi_value.value();
+    }
+
+    return names.size();
+}
+
+/**
+ * @brief Parse a pitch name into a PitchDiatonic, keeping its spelling.
+ */
+std::optional<PitchDiatonic> parse_diatonic_pitch(std::string_view str);
+
+/**
+ * @brief The original, regex-based implementation of parse_diatonic_pitch.
+ * Much slower, and kept only as a reference to check the parser against.
+ */
+std::optional<PitchDiatonic> parse_diatonic_pitch_regex(const std::string& str);
+
+inline namespace literals {
+
+/**
+ * @brief The MIDI value of a pitch name, e.g. "C#4"_pitch == 61. Invalid
+ * names don't compile.
+ */
+consteval unsigned int operator""_pitch(const char* str, size_t size)
+{
+    auto midi_value = midi_from_name({str, size});
+    if (!midi_value.has_value())
+    {
+        throw "invalid pitch name";
+    }
+
+    return midi_value.value();
+}
+
+}
+
 }
 
 #endif // PITCH_H_
\ No newline at end of file
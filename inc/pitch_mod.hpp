@@ -0,0 +1,94 @@
+#ifndef PITCH_MOD_H_
+#define PITCH_MOD_H_
+
+#include <cstddef>
+
+namespace MusicLib {
+
+/**
+ * @brief A voice's pitch modulation stage: glide (portamento), pitch bend and
+ * vibrato, all in the pitch domain, in fractional semitones.
+ *
+ * While any of them is active, the modulated pitch is turned into a phase
+ * increment per sample with Util::exp2_fast, a block at a time with SIMD,
+ * instead of calling std::pow per sample. While none is, voices keep
+ * rendering at a constant frequency, exactly as without modulation.
+ */
+class PitchMod
+{
+public:
+    explicit PitchMod(float glide = 0);
+    ~PitchMod() noexcept = default;
+
+    /**
+     * @brief Glide time in seconds: how long a glide to a new note takes,
+     * regardless of the interval. 0 disables gliding.
+     */
+    void glide(float glide);
+    float glide() const;
+
+    /**
+     * @brief Pitch bend, in semitones.
+     */
+    void bend(float bend);
+    float bend() const;
+
+    /**
+     * @brief Vibrato depth in semitones (the amplitude of a triangle LFO),
+     * and rate in Hz. A depth of 0 disables vibrato.
+     */
+    void vibrato(float depth, float rate);
+    float vibrato_depth() const;
+    float vibrato_rate() const;
+
+    /**
+     * @brief Start a note. Glides to its frequency from the previous note's
+     * pitch, if a glide time is set and there was a previous note, and
+     * jumps to it otherwise.
+     */
+    void note_on(float freq);
+
+    /**
+     * @brief Jump to a frequency, cancelling any glide.
+     */
+    void freq(float freq);
+
+    /**
+     * @brief Whether the pitch currently varies from the note's frequency.
+     */
+    bool is_active() const;
+
+    /**
+     * @brief Progress the modulation a single sample.
+     *
+     * @return The phase increment of the sample.
+     */
+    float process(float sample_duration);
+
+    /**
+     * @brief Progress the modulation a block of samples, writing the phase
+     * increment of each.
+     */
+    void process_block(float sample_duration, float* phase_increments, size_t frames);
+
+private:
+    // Pitches are in semitones relative to this frequency.
+    static constexpr float reference_freq = 440;
+
+    // Modulation settings
+    float m_glide;
+    float m_bend;
+    float m_vibrato_depth;
+    float m_vibrato_rate;
+
+    // State
+    float m_pitch;
+    float m_target;
+    float m_glide_speed;
+    float m_vibrato_phase;
+    bool m_has_note;
+};
+
+}
+
+#endif // PITCH_MOD_H_
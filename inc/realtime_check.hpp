@@ -0,0 +1,85 @@
+#ifndef REALTIME_CHECK_H_
+#define REALTIME_CHECK_H_
+
+#include <cstddef>
+#include <ostream>
+
+namespace MusicLib {
+
+/**
+ * @brief An opt-in debug mode that catches calls that aren't real-time
+ * safe on the audio thread: heap allocations and deallocations through
+ * operator new and delete, mutex locks and sleeps.
+ *
+ * It's compiled in only when MUSICLIB_REALTIME_CHECK is defined (the CMake
+ * option of the same name). Otherwise a Scope is empty and nothing is
+ * intercepted. Each violation is counted, and the stacks of the first ones
+ * are recorded, without allocating, to be reported later from another
+ * thread. Linux only, since it relies on symbol interposition.
+ */
+class RealtimeCheck
+{
+public:
+    enum class Violation
+    {
+        Allocation,
+        Deallocation,
+        Lock,
+        Sleep,
+        Count
+    };
+
+#ifdef MUSICLIB_REALTIME_CHECK
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    /**
+     * @brief Marks the calling thread as real-time for its lifetime. Used by
+     * the audio callbacks and render loops; scopes can be nested.
+     */
+    class Scope
+    {
+    public:
+#ifdef MUSICLIB_REALTIME_CHECK
+        explicit Scope(bool is_realtime = true);
+        ~Scope() noexcept;
+#else
+        explicit Scope(bool is_realtime [[maybe_unused]] = true)
+        {}
+#endif
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+#ifdef MUSICLIB_REALTIME_CHECK
+    private:
+        bool m_is_realtime;
+#endif
+    };
+
+    /**
+     * @brief Whether the calling thread is inside a real-time scope.
+     */
+    static bool is_realtime();
+
+    static size_t count(Violation violation);
+
+    /**
+     * @brief Total number of violations since the last reset.
+     */
+    static size_t count();
+
+    /**
+     * @brief Print the number of violations of each kind and the recorded
+     * stacks. Must not be called from a real-time scope.
+     */
+    static void report(std::ostream& os);
+
+    static void reset();
+};
+
+}
+
+#endif // REALTIME_CHECK_H_
@@ -35,6 +35,21 @@ public:
      */
     virtual void tick() = 0;
 
+    /**
+     * @brief Progress the track several samples at once. Equivalent to
+     * calling tick() the given number of times, provided it doesn't exceed
+     * samples_until_step(). Lets the audio callback render the whole span
+     * between two steps in a single block.
+     */
+    virtual void advance(unsigned long samples) = 0;
+
+    /**
+     * @brief The number of samples until the next step, or the maximal
+     * value of unsigned long if no step is pending (e.g. while stopped).
+     * Always at least 1.
+     */
+    virtual unsigned long samples_until_step() const = 0;
+
     /**
      * @brief Perform a single step in the arrangement.
      * Generally called from tick(), but kept public for the option
@@ -42,6 +57,15 @@ public:
      */
     virtual void step() = 0;
 
+    /**
+     * @brief Handle a command that doesn't come from the command stream,
+     * e.g. one sent live from a control thread. Only the time manager and
+     * device handlers are called, and the command stream isn't progressed.
+     */
+    virtual void execute(Command& cmd) = 0;
+
+    virtual void playing(bool playing) = 0;
+    virtual bool playing() const = 0;
     
     virtual void reset() = 0;
 };
@@ -63,12 +87,32 @@ public:
      */
     void tick() override;
 
+    void advance(unsigned long samples) override;
+
+    /**
+     * @brief The smallest number of samples until a step in any of the
+     * sequencers.
+     */
+    unsigned long samples_until_step() const override;
+
     /**
      * @brief Perform a step in each of the sequencers. This function is
      *        only here for completeness.
      */
     void step() override;
 
+    /**
+     * @brief Execute the command in each of the sequencers.
+     */
+    void execute(Command& cmd) override;
+
+    /**
+     * @brief Start or stop all sequencers. The sequencers count as playing
+     * if any of them is.
+     */
+    void playing(bool playing) override;
+    bool playing() const override;
+
     /**
      * @brief Reset all sequencers.
      * 
@@ -93,6 +137,8 @@ public:
     ~SequencerBasic() noexcept = default;
 
     void tick() override;
+    void advance(unsigned long samples) override;
+    unsigned long samples_until_step() const override;
 
     /**
      * @brief Receive a command from the command stream, call the command
@@ -101,6 +147,11 @@ public:
      */
     void step() override;
 
+    void execute(Command& cmd) override;
+
+    void playing(bool playing) override;
+    bool playing() const override;
+
     void reset() override;
 
 private:
@@ -122,6 +173,8 @@ public:
     ~SequencerMultiChannel() noexcept = default;
 
     void tick() override;
+    void advance(unsigned long samples) override;
+    unsigned long samples_until_step() const override;
 
     /**
      * @brief Receive and execute a command from each of the command
@@ -129,6 +182,11 @@ public:
      */
     void step() override;
 
+    void execute(Command& cmd) override;
+
+    void playing(bool playing) override;
+    bool playing() const override;
+
     /**
      * @brief Reset all channels (return their playhead to the first command)
      * 
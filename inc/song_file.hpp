@@ -0,0 +1,252 @@
+#ifndef SONG_FILE_H_
+#define SONG_FILE_H_
+
+#include "command.hpp"
+#include "command_stream.hpp"
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace MusicLib {
+
+/**
+ * @brief The header at the start of a compiled song file. All fields are
+ * stored in the host's byte order, which must be little-endian.
+ */
+struct SongHeader
+{
+    char magic[8];
+    uint32_t version;
+
+    // Identifies the event type, chosen by the application.
+    uint32_t format;
+
+    uint32_t instrument_size;
+    uint32_t instrument_count;
+    uint32_t event_size;
+    uint32_t reserved;
+    uint64_t event_count;
+
+    // Offsets from the start of the file.
+    uint64_t instruments_offset;
+    uint64_t events_offset;
+};
+
+/**
+ * @brief An entry of a compiled song's instrument table.
+ */
+struct SongInstrument
+{
+    uint32_t id;
+
+    // Chosen by the application, e.g. a preset number.
+    uint32_t type;
+
+    float vol;
+    float pan;
+};
+
+/**
+ * @brief A compiled song: a header, an instrument table and an array of
+ * fixed-width events, mapped read-only into memory instead of being read.
+ * Opening a song takes the same time regardless of its size, its pages are
+ * loaded on first access, and processes that play the same song share them
+ * through the page cache.
+ * 
+ * Events are trivially copyable structs that are written and mapped back as
+ * they are in memory, so a file can only be read on a platform with the
+ * same layout as the one that wrote it.
+ */
+class SongFile
+{
+public:
+    static constexpr uint32_t version = 1;
+
+    /**
+     * @brief Map a compiled song. Throws std::runtime_error if the file
+     * can't be mapped, isn't a compiled song or is of another version.
+     */
+    explicit SongFile(const std::string& filename);
+    ~SongFile() noexcept = default;
+
+    SongFile(const SongFile&) = delete;
+    SongFile& operator=(const SongFile&) = delete;
+    SongFile(SongFile&&) noexcept = default;
+    SongFile& operator=(SongFile&&) noexcept = default;
+
+    /**
+     * @brief Whether the file starts like a compiled song.
+     */
+    static bool is_song_file(const std::string& filename);
+
+    /**
+     * @brief Write a compiled song. Throws std::runtime_error if the file
+     * can't be written.
+     */
+    template <typename E>
+    static void write(const std::string& filename, uint32_t format,
+        std::span<const SongInstrument> instruments, std::span<const E> events)
+    {
+        static_assert(std::is_trivially_copyable_v<E>, "events must be trivially copyable");
+        write(filename, format, instruments, events.data(), sizeof(E), events.size());
+    }
+
+    static void write(const std::string& filename, uint32_t format,
+        std::span<const SongInstrument> instruments, const void* events, size_t event_size, size_t event_count);
+
+    uint32_t format() const;
+
+    std::span<const SongInstrument> instruments() const;
+
+    /**
+     * @brief The events, in place in the mapped file. Throws
+     * std::runtime_error if their size in the file isn't the size of E.
+     */
+    template <typename E>
+    std::span<const E> events() const
+    {
+        static_assert(std::is_trivially_copyable_v<E>, "events must be trivially copyable");
+
+        const SongHeader* h = header();
+        if (h->event_size != sizeof(E) || h->events_offset % alignof(E) != 0)
+        {
+            throw std::runtime_error("compiled song events don't match the event type");
+        }
+
+        return {reinterpret_cast<const E*>(m_file.data() + h->events_offset), (size_t) h->event_count};
+    }
+
+private:
+    const SongHeader* header() const;
+
+private:
+    MappedFile m_file;
+};
+
+/**
+ * @brief A command stream that plays events in place, e.g. from a mapped
+ * song file. Nothing is loaded, parsed or copied up front. The events
+ * themselves are exposed without copying through events() and
+ * current_event(). The command interface isn't zero-copy, though: since a
+ * command carries a vtable that a mapped event can't, current() copies the
+ * current event into a single command owned by the stream. Read-only, since
+ * the events aren't owned.
+ * 
+ * @tparam C Command type, constructible from an event.
+ * @tparam E Event type.
+ */
+template <typename C, typename E>
+class CommandStreamMapped final : public CommandStream
+{
+    static_assert(std::is_base_of_v<Command, C>, "class C must be derived from Command");
+    static_assert(std::is_constructible_v<C, const E&>, "class C must be constructible from an event");
+
+public:
+    explicit CommandStreamMapped(std::span<const E> events, bool looping = false)
+    : m_events{events}
+    , m_current{}
+    , m_cursor{0}
+    , m_looping{looping}
+    {}
+
+    ~CommandStreamMapped() noexcept = default;
+    CommandStreamMapped(const CommandStreamMapped&) = default;
+    CommandStreamMapped& operator=(const CommandStreamMapped&) = default;
+    CommandStreamMapped(CommandStreamMapped&&) noexcept = default;
+    CommandStreamMapped& operator=(CommandStreamMapped&&) noexcept = default;
+
+    /**
+     * @brief Not supported. Throws std::logic_error.
+     */
+    void add(Command& command [[maybe_unused]]) override
+    {
+        throw std::logic_error("cannot add commands to a mapped command stream");
+    }
+
+    size_t size() const
+    {
+        return m_events.size();
+    }
+
+    /**
+     * @brief The current event, copied into the stream's command. The
+     * command is overwritten by the next call, so it's only valid until
+     * then.
+     */
+    Command* current() const override
+    {
+        if (m_cursor >= m_events.size())
+        {
+            return nullptr;
+        }
+
+        m_current = C{m_events[m_cursor]};
+        return &m_current;
+    }
+
+    /**
+     * @brief The events, in place.
+     */
+    std::span<const E> events() const
+    {
+        return m_events;
+    }
+
+    /**
+     * @brief The current event, in place. The stream must not be empty.
+     */
+    const E& current_event() const
+    {
+        return m_events[m_cursor];
+    }
+
+    bool finished() const override
+    {
+        return !m_looping && m_cursor >= m_events.size() - 1;
+    }
+
+    void reset() override
+    {
+        cursor(0);
+    }
+
+    unsigned long step() override
+    {
+        if (m_cursor < m_events.size() - 1)
+        {
+            ++m_cursor;
+        }
+        else
+        {
+            if (m_looping)
+            {
+                m_cursor = 0;
+            }
+        }
+
+        return m_cursor;
+    }
+
+    void cursor(unsigned long cursor) override
+    {
+        if (cursor < m_events.size())
+        {
+            m_cursor = cursor;
+        }
+    }
+
+private:
+    std::span<const E> m_events;
+    mutable C m_current;
+    unsigned long m_cursor;
+    bool m_looping;
+};
+
+}
+
+#endif // SONG_FILE_H_
@@ -0,0 +1,214 @@
+#ifndef SONG_PARSER_H_
+#define SONG_PARSER_H_
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace MusicLib {
+
+/**
+ * @brief One line of a text song, split into whitespace-separated tokens.
+ * The tokens point into the parsed text, so nothing is copied or allocated.
+ */
+class SongLine
+{
+public:
+    static constexpr size_t tokens_max = 16;
+
+public:
+    explicit SongLine()
+    : m_tokens{}
+    , m_size{0}
+    , m_number{0}
+    {}
+
+    ~SongLine() noexcept = default;
+
+    /**
+     * @brief Line number, starting from 1.
+     */
+    size_t number() const
+    {
+        return m_number;
+    }
+
+    /**
+     * @brief Number of tokens. Never 0, since blank lines are skipped.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief The numbered token, or an empty one if the line is shorter.
+     */
+    std::string_view operator[](size_t index) const
+    {
+        return index < m_size ? m_tokens[index] : std::string_view{};
+    }
+
+    /**
+     * @brief Convert the numbered token to a number with std::from_chars.
+     * Returns false, leaving the value unchanged, if the token is missing,
+     * isn't entirely a number of type T, or is out of T's range.
+     */
+    template <typename T>
+    bool get(size_t index, T& value) const
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "tokens convert to numbers only");
+
+        if (index >= m_size)
+        {
+            return false;
+        }
+
+        const char* first = m_tokens[index].data();
+        const char* last = first + m_tokens[index].size();
+        T result;
+        auto [end, ec] = std::from_chars(first, last, result);
+
+        if (ec != std::errc{} || end != last)
+        {
+            return false;
+        }
+
+        value = result;
+        return true;
+    }
+
+private:
+    friend class SongParser;
+
+    std::array<std::string_view, tokens_max> m_tokens;
+    size_t m_size;
+    size_t m_number;
+};
+
+/**
+ * @brief An error found in a text song.
+ */
+struct SongParseError
+{
+    size_t line;
+
+    // A string literal.
+    const char* message;
+};
+
+/**
+ * @brief A tokenizer for line-based text songs, in which every line holds a
+ * command name followed by its arguments, separated by whitespace.
+ *
+ * The text is parsed in place and nothing is allocated, so a song can be
+ * parsed straight out of a MappedFile. Larger texts can also be fed in
+ * chunks, in which case lines that span chunks are reassembled in a fixed
+ * buffer of line_length_max characters.
+ *
+ * Interpreting the tokens is left to the application, which reports invalid
+ * lines back through error(). The first errors_max errors are kept along
+ * with their line numbers, and the rest are only counted.
+ *
+ * Usage:
+ *
+ *     SongParser parser{text};
+ *     SongLine line;
+ *     while (parser.next(line))
+ *     {
+ *         ...
+ *     }
+ */
+class SongParser
+{
+public:
+    static constexpr size_t line_length_max = 4096;
+    static constexpr size_t errors_max = 64;
+
+public:
+    explicit SongParser();
+
+    /**
+     * @brief Parse a whole text, which must outlive the parser's lines.
+     */
+    explicit SongParser(std::string_view text);
+
+    ~SongParser() noexcept = default;
+
+    // Lines may point into the parser.
+    SongParser(const SongParser&) = delete;
+    SongParser& operator=(const SongParser&) = delete;
+
+    /**
+     * @brief Continue with the next chunk of text, once every line of the
+     * previous one has been read. The chunk must stay alive until next()
+     * returns false again.
+     */
+    void feed(std::string_view chunk);
+
+    /**
+     * @brief Mark the end of the text, so a last line that isn't terminated
+     * by a newline is read too.
+     */
+    void finish();
+
+    /**
+     * @brief Read the next non-blank line. Returns false once the current
+     * chunk is used up. The line stays valid until the next call.
+     */
+    bool next(SongLine& line);
+
+    /**
+     * @brief Report a line as invalid.
+     *
+     * @param message A string literal.
+     */
+    void error(const SongLine& line, const char* message);
+
+    /**
+     * @brief Number of lines read so far, including blank ones.
+     */
+    size_t lines() const;
+
+    /**
+     * @brief Number of errors reported so far. May be larger than
+     * errors().size().
+     */
+    size_t error_count() const;
+
+    std::span<const SongParseError> errors() const;
+
+    /**
+     * @brief An upper bound on the number of lines of a text, and so on the
+     * number of commands parsed from it, e.g. to reserve a command stream.
+     */
+    static size_t count_lines(std::string_view text);
+
+private:
+    bool next_text(std::string_view& text);
+    void carry(std::string_view text);
+    void error(size_t line, const char* message);
+
+private:
+    // What's left of the current chunk.
+    std::string_view m_chunk;
+    bool m_finished;
+    size_t m_lines;
+
+    // The start of a line that continues in the next chunk.
+    std::array<char, line_length_max> m_carry;
+    size_t m_carry_size;
+    bool m_carry_overflow;
+    bool m_carry_read;
+
+    std::array<SongParseError, errors_max> m_errors;
+    size_t m_error_count;
+};
+
+}
+
+#endif // SONG_PARSER_H_
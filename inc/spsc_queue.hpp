@@ -0,0 +1,130 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include "util.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace MusicLib {
+
+/**
+ * @brief A wait-free, fixed-capacity ring buffer for passing messages from
+ * exactly one producer thread to exactly one consumer thread. Neither side
+ * ever locks or allocates, so either may be the audio thread.
+ * 
+ * @tparam T Message type. Copied into preallocated slots, so it should be
+ * copyable without allocating.
+ * @tparam N Capacity. Must be a power of two.
+ */
+template <typename T, size_t N = 256>
+class SPSCQueue
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    explicit SPSCQueue()
+    : m_slots{}
+    , m_head{0}
+    , m_tail{0}
+    {
+    }
+
+    ~SPSCQueue() noexcept = default;
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /**
+     * @brief Producer side. Copy a message into the queue.
+     * 
+     * @return false if the queue is full, in which case nothing is copied.
+     */
+    bool push(const T& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == N)
+        {
+            return false;
+        }
+
+        m_slots[tail & (N - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side. Access the oldest message without removing it.
+     * 
+     * @return A pointer to the message, or nullptr if the queue is empty.
+     * Valid until pop() is called.
+     */
+    T* front()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return &m_slots[head & (N - 1)];
+    }
+
+    const T* front() const
+    {
+        return const_cast<SPSCQueue*>(this)->front();
+    }
+
+    /**
+     * @brief Consumer side. Remove the oldest message. Must only be called
+     * after front() returned a message.
+     */
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer side. Copy out and remove the oldest message.
+     * 
+     * @return false if the queue is empty.
+     */
+    bool pop(T& value)
+    {
+        T* slot = front();
+
+        if (!slot)
+        {
+            return false;
+        }
+
+        value = *slot;
+        pop();
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+private:
+    std::array<T, N> m_slots;
+
+    // The indices grow without wrapping around N. Each one is written by a
+    // single thread, so they're kept on separate cache lines.
+    alignas(Util::cache_line_size) std::atomic<size_t> m_head;
+    alignas(Util::cache_line_size) std::atomic<size_t> m_tail;
+};
+
+}
+
+#endif // SPSC_QUEUE_H_
@@ -0,0 +1,113 @@
+#ifndef TEMPO_MAP_H_
+#define TEMPO_MAP_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace MusicLib {
+
+/**
+ * @brief The timing of every step of a song, precompiled from its tempo and
+ * shuffle changes.
+ *
+ * Each change starts a segment, which holds the exact position of its first
+ * step: a whole sample plus a fractional carry, so rounding never
+ * accumulates, however long the song. Converting between steps and samples
+ * is a binary search for the segment followed by a constant time
+ * computation within it.
+ *
+ * Shuffle is the share of each pair of steps taken by its first (even)
+ * step: .5 is straight, and 2/3 is a triplet swing.
+ */
+class TempoMap
+{
+public:
+    /**
+     * @brief A map with a single tempo, from step 0 on. Throws
+     * std::runtime_error if the tempo or shuffle is invalid.
+     */
+    explicit TempoMap(unsigned long sample_rate, float bpm = 120, unsigned int steps_per_beat = 4,
+        float shuffle = .5);
+    ~TempoMap() noexcept = default;
+
+    /**
+     * @brief Change the tempo and shuffle from a step on, until the next
+     * change. Replaces a change already at that step. Positions of earlier
+     * steps, the given step included, are unaffected. Throws
+     * std::runtime_error if bpm isn't positive or shuffle isn't strictly
+     * between 0 and 1.
+     *
+     * Not real-time safe in general: it allocates when the number of changes
+     * exceeds the reserved capacity, and recompiles every later change.
+     * Replacing a change, or adding one after the last, within the reserved
+     * capacity, takes constant time and doesn't allocate.
+     */
+    void change(unsigned long step, float bpm, float shuffle = .5);
+
+    /**
+     * @brief Steps per beat of later calls to change(). Existing changes
+     * keep the value they were made with.
+     */
+    void steps_per_beat(unsigned int steps_per_beat);
+    unsigned int steps_per_beat() const;
+
+    void reserve(size_t changes);
+    size_t changes() const;
+
+    unsigned long sample_rate() const;
+    float bpm(unsigned long step) const;
+    float shuffle(unsigned long step) const;
+
+    /**
+     * @brief The duration of a step in seconds, without shuffle.
+     */
+    double step_duration(unsigned long step) const;
+
+    /**
+     * @brief The sample during which a step starts.
+     */
+    unsigned long sample_of_step(unsigned long step) const;
+
+    /**
+     * @brief The last step that starts at or before a sample.
+     */
+    unsigned long step_at_sample(unsigned long sample) const;
+
+private:
+    struct Segment
+    {
+        unsigned long step;
+        unsigned long sample;
+        double carry;
+        double samples_per_step;
+        float bpm;
+        float shuffle;
+    };
+
+    /**
+     * @brief The segment a step is in.
+     */
+    const Segment& segment_of_step(unsigned long step) const;
+
+    static void validate(float bpm, float shuffle);
+
+    /**
+     * @brief The number of samples from the start of a segment's first
+     * sample to the start of a step in it, carry included.
+     */
+    static double offset(const Segment& segment, unsigned long step);
+
+    /**
+     * @brief Recompute the positions of the segments from the given one on.
+     */
+    void compile(size_t first);
+
+private:
+    unsigned long m_sample_rate;
+    unsigned int m_steps_per_beat;
+    std::vector<Segment> m_segments;
+};
+
+}
+
+#endif // TEMPO_MAP_H_
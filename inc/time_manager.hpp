@@ -1,6 +1,10 @@
 #ifndef TIME_MANAGER_H_
 #define TIME_MANAGER_H_
 
+#include "tempo_map.hpp"
+
+#include <cstddef>
+
 namespace MusicLib {
     
 /**
@@ -18,6 +22,22 @@ public:
     virtual bool playing() const = 0;
 
     virtual bool count_sample() = 0;
+
+    /**
+     * @brief Count several samples at once. Equivalent to calling
+     * count_sample() the given number of times, provided it doesn't exceed
+     * samples_until_step().
+     * 
+     * @return Whether a step is due after the last counted sample.
+     */
+    virtual bool count_samples(unsigned long samples) = 0;
+
+    /**
+     * @brief The number of samples until the next step, i.e. the number of
+     * count_sample() calls up to and including the one that returns true.
+     * Always at least 1.
+     */
+    virtual unsigned long samples_until_step() const = 0;
 };
 
 class TimeManagerEventBased : public TimeManager
@@ -30,6 +50,8 @@ public:
     bool playing() const override;
 
     bool count_sample() override;
+    bool count_samples(unsigned long samples) override;
+    unsigned long samples_until_step() const override;
     void reset_counter(unsigned long samples_until_next_step);
 
 private:
@@ -37,33 +59,93 @@ private:
     unsigned long m_sample_counter;
 };
 
+/**
+ * @brief A time manager that performs steps at the times given by a tempo
+ * map, so step times never drift, and moving to any point of the song costs
+ * a binary search.
+ */
 class TimeManagerTempo : public TimeManager
 {
+public:
+    static constexpr size_t live_changes_max = 4096;
+
 public:
     explicit TimeManagerTempo(unsigned long sample_rate, float bpm = 120, unsigned int steps_per_beat = 4, float shuffle = .5);
+    explicit TimeManagerTempo(const TempoMap& tempo_map);
     ~TimeManagerTempo() noexcept = default;
 
     void playing(bool playing) override;
     bool playing() const override;
 
     bool count_sample() override;
+    bool count_samples(unsigned long samples) override;
+    unsigned long samples_until_step() const override;
 
+    /**
+     * @brief The tempo of the step in progress. Setting it changes the tempo
+     * from the next step on, until the tempo map's next change. Ignored if
+     * not positive.
+     *
+     * Live changes are kept in the tempo map, so steps that have played keep
+     * the positions they played at, and seeking back to them is exact. Room
+     * for live_changes_max of them is reserved up front; changes made before
+     * the same step replace each other, and beyond that many changes at
+     * different steps, a change may allocate.
+     */
     float bpm() const;
     void bpm(float bpm);
 
+    /**
+     * @brief The shuffle of the step in progress. Setting it changes it as
+     * bpm() does. Ignored if not strictly between 0 and 1.
+     */
+    float shuffle() const;
+    void shuffle(float shuffle);
+
+    /**
+     * @brief Change the steps per beat from the next step on, keeping the
+     * tempo. Ignored if 0.
+     */
     void steps_per_beat(unsigned int steps_per_beat);
 
-    float step_duration();
+    /**
+     * @brief The duration of the step in progress, in seconds, without
+     * shuffle.
+     */
+    float step_duration() const;
+
+    /**
+     * @brief The number of samples counted since step 0.
+     */
+    unsigned long sample() const;
+
+    /**
+     * @brief The last step that was due.
+     */
+    unsigned long step() const;
+
+    /**
+     * @brief Move to a sample, e.g. to seek or loop. The next step due is
+     * the first one after it.
+     */
+    void seek(unsigned long sample);
+
+    const TempoMap& tempo_map() const;
+
+private:
+    /**
+     * @brief Change the tempo from the next step on. The next step's
+     * position depends only on earlier steps, so it stays due at the same
+     * sample.
+     */
+    void live_change(float bpm, float shuffle);
 
 private:
     bool m_playing;
-    float m_bpm;
-    unsigned int m_steps_per_beat;
-    float m_step_duration;
-    unsigned long m_sample_rate;
-    unsigned long m_samples_per_step;
-    unsigned long m_sample_counter;
-    float m_shuffle;
+    TempoMap m_tempo_map;
+    unsigned long m_sample;
+    unsigned long m_next_step;
+    unsigned long m_next_sample;
 };
 }
 
@@ -0,0 +1,267 @@
+#ifndef TUNING_H_
+#define TUNING_H_
+
+#include "util.hpp"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace MusicLib {
+
+/**
+ * @brief A table of the frequencies of all 128 MIDI pitches.
+ *
+ * Tables are generated once, at compile time if declared constexpr, so
+ * looking up the frequency of a pitch costs the same in any tuning:
+ *
+ *     constexpr Tuning quarter_tones = Tuning::edo(24);
+ *     constexpr Tuning baroque = Tuning::edo(12, 415);
+ *     constexpr Tuning just = Tuning::scala(just_scl, 261.63, 60);
+ *
+ * One tuning is current, and is used by PitchChromatic and PitchDiatonic. It
+ * is swapped with an atomic pointer exchange, so it can be changed while the
+ * audio thread is reading it.
+ */
+class Tuning
+{
+public:
+    static constexpr size_t size = 128;
+
+public:
+    explicit constexpr Tuning(const std::array<float, size>& freqs)
+    : m_freqs{freqs}
+    {}
+
+    /**
+     * @brief An equal division of the octave into the given number of steps,
+     * one per MIDI pitch.
+     *
+     * @param reference_freq The frequency of the reference pitch.
+     * @param reference_pitch The MIDI value of the reference pitch.
+     */
+    static constexpr Tuning edo(unsigned int divisions = 12, float reference_freq = 440,
+        unsigned int reference_pitch = 69)
+    {
+        std::array<float, size> freqs{};
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            freqs[i] = reference_freq * Util::exp2(((double) i - reference_pitch) / divisions);
+        }
+
+        return Tuning{freqs};
+    }
+
+    /**
+     * @brief A scale repeated over the range of MIDI pitches, one degree per
+     * pitch, with the root on the reference pitch.
+     *
+     * @param ratios The ratio of every degree above the root to the root, in
+     * the order of a Scala file: the last one is the period of the scale,
+     * usually 2 (an octave). Throws std::runtime_error if it's empty.
+     */
+    static constexpr Tuning scale(std::span<const double> ratios, float reference_freq = 440,
+        unsigned int reference_pitch = 69)
+    {
+        if (ratios.empty())
+        {
+            throw std::runtime_error("a scale needs at least one degree");
+        }
+
+        std::array<float, size> freqs{};
+        const long degrees = ratios.size();
+        const double period = ratios.back();
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            long steps = (long) i - (long) reference_pitch;
+            long periods = steps >= 0 ? steps / degrees : -((degrees - 1 - steps) / degrees);
+            long degree = steps - periods * degrees;
+
+            double freq = reference_freq * (degree == 0 ? 1 : ratios[degree - 1]);
+            for (long p = 0; p < periods; ++p)
+            {
+                freq *= period;
+            }
+            for (long p = 0; p > periods; --p)
+            {
+                freq /= period;
+            }
+
+            freqs[i] = freq;
+        }
+
+        return Tuning{freqs};
+    }
+
+    /**
+     * @brief A scale given in the Scala (.scl) format, repeated as in
+     * scale(). Usable at compile time. Throws std::runtime_error if the text
+     * isn't a valid scale.
+     *
+     * @param scl The contents of a .scl file: '!' comment lines, a
+     * description line, the number of degrees, and then a line per degree
+     * holding either cents, with a decimal point, or a ratio such as 3/2.
+     */
+    static constexpr Tuning scala(std::string_view scl, float reference_freq = 440,
+        unsigned int reference_pitch = 69)
+    {
+        std::vector<double> ratios;
+        bool has_description = false;
+        bool has_count = false;
+        size_t count = 0;
+
+        while (!scl.empty())
+        {
+            size_t end = scl.find('\n');
+            std::string_view line = scl.substr(0, end);
+            scl.remove_prefix(end == std::string_view::npos ? scl.size() : end + 1);
+
+            if (!line.empty() && line[0] == '!')
+            {
+                continue;
+            }
+
+            if (!has_description)
+            {
+                has_description = true;
+            }
+            else if (!has_count)
+            {
+                count = (size_t) parse_scala_value(line, false);
+                has_count = true;
+            }
+            else if (ratios.size() < count)
+            {
+                ratios.push_back(parse_scala_value(line, true));
+            }
+        }
+
+        if (!has_count || ratios.size() != count)
+        {
+            throw std::runtime_error("incomplete Scala scale");
+        }
+
+        return scale(ratios, reference_freq, reference_pitch);
+    }
+
+    /**
+     * @brief The frequency of a MIDI pitch, or 0 if it's out of range.
+     */
+    constexpr float freq(unsigned int midi_value) const
+    {
+        return midi_value < size ? m_freqs[midi_value] : 0;
+    }
+
+    constexpr std::span<const float, size> freqs() const
+    {
+        return m_freqs;
+    }
+
+    /**
+     * @brief The current tuning: 12-EDO with A4 at 440 Hz, unless another
+     * has been made current. Lock-free.
+     */
+    static const Tuning& current();
+
+    /**
+     * @brief Make a tuning current, with an atomic pointer exchange, and
+     * return the previous one. Lock-free. The tuning isn't copied, so it must
+     * stay alive for as long as it's current, and the previous one must stay
+     * alive until the audio thread is done with it, e.g. until its next
+     * callback.
+     */
+    static const Tuning& use(const Tuning& tuning);
+
+private:
+    /**
+     * @brief Parse the number at the start of a line of a Scala file. Cents
+     * are turned into a ratio.
+     */
+    static constexpr double parse_scala_value(std::string_view line, bool is_pitch)
+    {
+        size_t i = 0;
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+        {
+            ++i;
+        }
+
+        bool is_negative = i < line.size() && line[i] == '-';
+        if (is_negative)
+        {
+            ++i;
+        }
+
+        double value = 0;
+        double denominator = 1;
+        double place = 1;
+        bool has_digits = false;
+        bool is_cents = false;
+        bool is_ratio = false;
+
+        for (; i < line.size(); ++i)
+        {
+            char c = line[i];
+
+            if (c >= '0' && c <= '9')
+            {
+                has_digits = true;
+                if (is_ratio)
+                {
+                    denominator = denominator * 10 + (c - '0');
+                }
+                else if (is_cents)
+                {
+                    place /= 10;
+                    value += (c - '0') * place;
+                }
+                else
+                {
+                    value = value * 10 + (c - '0');
+                }
+            }
+            else if (c == '.' && is_pitch && !is_cents && !is_ratio)
+            {
+                is_cents = true;
+            }
+            else if (c == '/' && is_pitch && !is_cents && !is_ratio && has_digits)
+            {
+                is_ratio = true;
+                denominator = 0;
+            }
+            else
+            {
+                // The rest of the line is a comment.
+                break;
+            }
+        }
+
+        if (!has_digits || (is_negative && !is_cents) || denominator == 0 || (!is_cents && is_pitch && value == 0))
+        {
+            throw std::runtime_error("invalid value in Scala scale");
+        }
+
+        if (is_cents)
+        {
+            return Util::exp2((is_negative ? -value : value) / 1200);
+        }
+
+        return value / denominator;
+    }
+
+private:
+    std::array<float, size> m_freqs;
+};
+
+/**
+ * @brief Standard tuning: 12-EDO with A4 at 440 Hz.
+ */
+inline constexpr Tuning tuning_standard = Tuning::edo();
+
+}
+
+#endif // TUNING_H_
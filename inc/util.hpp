@@ -1,13 +1,144 @@
 #ifndef UTIL_H_
 #define UTIL_H_
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <vector>
 
 namespace MusicLib {
 
 namespace Util {
 
+/**
+ * @brief The largest number of frames a block method renders at once into
+ * scratch buffers on the stack. Longer blocks are split into chunks of this
+ * size.
+ */
+constexpr size_t block_size_max = 1024;
+
+/**
+ * @brief Alignment used to keep data written by different threads on
+ * separate cache lines.
+ */
+constexpr size_t cache_line_size = 64;
+
+/**
+ * @brief 2 to the power of x, usable at compile time, e.g. to generate
+ * tables. Accurate to about a double's precision, but much slower than
+ * std::exp2.
+ */
+constexpr double exp2(double x)
+{
+    // Split x into an integer and a fraction in [0, 1).
+    long long whole = (long long) x;
+    if (whole > x)
+    {
+        --whole;
+    }
+    double frac = x - whole;
+
+    // e^(frac * ln 2), from its Taylor series. It converges quickly, since
+    // frac * ln 2 is below 0.7.
+    constexpr double ln2 = 0.693147180559945309417;
+    double term = 1;
+    double result = 1;
+    for (int n = 1; n < 24; ++n)
+    {
+        term *= frac * ln2 / n;
+        result += term;
+    }
+
+    // 2^whole, by squaring.
+    double base = whole >= 0 ? 2 : .5;
+    unsigned long long n = whole >= 0 ? whole : -whole;
+    for (; n > 0; n >>= 1)
+    {
+        if (n & 1)
+        {
+            result *= base;
+        }
+        base *= base;
+    }
+
+    return result;
+}
+
+/**
+ * @brief A fast approximation of 2^x, for computing frequencies from pitches
+ * at audio rate. The relative error is below 2e-7 (0.0003 cents). x is
+ * clamped to [-125, 127], so the result is always a normal float.
+ */
+inline float exp2_fast(float x)
+{
+    x = std::min(std::max(x, -125.f), 127.f);
+
+    // Split x into an integer and a fraction in [0, 1).
+    int32_t whole = (int32_t) x;
+    whole -= x < whole;
+    float frac = x - whole;
+
+    // 2^frac, by a polynomial fitted to minimize the relative error.
+    float result = 0.0018775762f;
+    result = result * frac + 0.0089893416f;
+    result = result * frac + 0.0558263175f;
+    result = result * frac + 0.2401536107f;
+    result = result * frac + 0.6931530833f;
+    result = result * frac + 0.9999999404f;
+
+    // Multiply by 2^whole by adding to the exponent.
+    return std::bit_cast<float>(std::bit_cast<int32_t>(result) + (whole << 23));
+}
+
+/**
+ * @brief An allocator that aligns its storage, e.g. to a cache line or a
+ * SIMD register.
+ * 
+ * @tparam T Element type.
+ * @tparam A Alignment in bytes.
+ */
+template <typename T, size_t A = cache_line_size>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, A>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, A>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{A}));
+    }
+
+    void deallocate(T* ptr, size_t n [[maybe_unused]]) noexcept
+    {
+        ::operator delete(ptr, std::align_val_t{A});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, A>&) const noexcept
+    {
+        return true;
+    }
+};
+
+template <typename T, size_t A = cache_line_size>
+using AlignedVector = std::vector<T, AlignedAllocator<T, A>>;
+
 /**
  * @brief Create a copy of the given object, encased in a smart pointer of
  * a given type. A supplement to the clone method some classes have that 
@@ -3,12 +3,16 @@
 
 #include "envelope.hpp"
 #include "osc.hpp"
+#include "pitch_mod.hpp"
 #include "wave_shaper.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <type_traits>
+#include <typeinfo>
 #include <stdexcept>
 
 namespace MusicLib {
@@ -48,6 +52,22 @@ public:
      * @param output 
      */
     virtual void process(float sample_duration, float& output) = 0;
+
+    /**
+     * @brief Progress the voice's audio signal a block of samples. Falls back
+     * to calling process() once per sample.
+     * 
+     * @param sample_duration The length of a sample in seconds.
+     * @param output A buffer of at least frames samples.
+     * @param frames 
+     */
+    virtual void process_block(float sample_duration, float* output, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i)
+        {
+            process(sample_duration, output[i]);
+        }
+    }
 };
 
 
@@ -204,6 +224,27 @@ public:
         }
     }
 
+    void process_block(float sample_duration, float* output, size_t frames) override
+    {
+        float temp[Util::block_size_max];
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+            float* out = output + offset;
+
+            std::fill(out, out + chunk, 0.0f);
+            for (auto& v : m_voices)
+            {
+                v->process_block(sample_duration, temp, chunk);
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    out[i] += m_vol * temp[i];
+                }
+            }
+        }
+    }
+
 private:
     std::vector<std::unique_ptr<V>> m_voices;
     std::unique_ptr<E> m_env;
@@ -239,9 +280,12 @@ public:
     , m_freq{freq}
     , m_phase{0}
     , m_vol{vol}
+    , m_pitch_mod{}
     {
         static_assert(std::is_base_of_v<Oscillator, O>, "class O must be derived from Oscillator");
         static_assert(std::is_base_of_v<Envelope, E>, "class E must be derived from Envelope");
+
+        m_pitch_mod.freq(freq);
     }
 
     ~VoiceOsc() noexcept = default;
@@ -252,6 +296,7 @@ public:
     , m_freq{other.m_freq}
     , m_phase{other.m_phase}
     , m_vol{other.m_vol}
+    , m_pitch_mod{other.m_pitch_mod}
     {
 
     }
@@ -265,6 +310,7 @@ public:
             m_freq = other.m_freq;
             m_phase = other.m_phase;
             m_vol = other.m_vol;
+            m_pitch_mod = other.m_pitch_mod;
         }
         return *this;
     }
@@ -301,6 +347,7 @@ public:
     void freq(float freq) override
     {
         m_freq = freq;
+        m_pitch_mod.freq(freq);
     }
 
     float freq() const override
@@ -322,6 +369,7 @@ public:
         }
 
         m_freq = freq;
+        m_pitch_mod.note_on(freq);
         m_env->trig(true);
     }
 
@@ -337,16 +385,46 @@ public:
 
     void process(float sample_duration, float& output) override
     {
-        output = m_vol * m_osc->value(m_phase) * m_env->process(sample_duration);
+        float phase_increment = m_pitch_mod.is_active() ? m_pitch_mod.process(sample_duration) : sample_duration * m_freq;
+        output = m_vol * m_osc->value_with_increment(m_phase, phase_increment) * m_env->process(sample_duration);
 
         // Propagate phase.
-        m_phase += sample_duration * m_freq;
+        m_phase += phase_increment;
         if (m_phase >= 1)
         {
             m_phase -= 1;
         }
     }
 
+    void process_block(float sample_duration, float* output, size_t frames) override
+    {
+        float env[Util::block_size_max];
+        float phase_increments[Util::block_size_max];
+        float phase_increment = sample_duration * m_freq;
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+            float* out = output + offset;
+
+            if (m_pitch_mod.is_active())
+            {
+                m_pitch_mod.process_block(sample_duration, phase_increments, chunk);
+                m_phase = m_osc->process_block_modulated(m_phase, phase_increments, out, chunk);
+            }
+            else
+            {
+                m_phase = m_osc->process_block(m_phase, phase_increment, out, chunk);
+            }
+            m_env->process_block(sample_duration, env, chunk);
+
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                out[i] = m_vol * out[i] * env[i];
+            }
+        }
+    }
+
     void osc(O& osc)
     {
         m_osc = clone<O>(osc);
@@ -362,6 +440,19 @@ public:
         return *m_osc;
     }
 
+    /**
+     * @brief The voice's glide, pitch bend and vibrato.
+     */
+    PitchMod& pitch_mod()
+    {
+        return m_pitch_mod;
+    }
+
+    const PitchMod& pitch_mod() const
+    {
+        return m_pitch_mod;
+    }
+
     template <typename O2 = Oscillator>
     O2& osc()
     {
@@ -374,6 +465,188 @@ private:
     float m_freq;
     float m_phase;
     float m_vol;
+    PitchMod m_pitch_mod;
+};
+
+/**
+ * @brief A voice like VoiceOsc, but holding its oscillator and envelope by
+ * value, for patches that are fixed at compile time.
+ *
+ * O and E must be concrete classes. The voice calls their methods with
+ * qualified names, so the calls are bound statically instead of going
+ * through a pointer and a virtual call, and can be inlined when the
+ * definitions are visible. The class is final, so that an instrument
+ * holding it can call it statically too.
+ *
+ * @tparam O Oscillator type
+ * @tparam E Envelope type
+ */
+template <typename O, typename E>
+class VoiceStatic final : public Voice
+{
+public:
+    explicit VoiceStatic(const O& osc, const E& env, float freq = 440, float vol = 1.)
+    : m_osc{osc}
+    , m_env{env}
+    , m_freq{freq}
+    , m_phase{0}
+    , m_vol{vol}
+    , m_pitch_mod{}
+    {
+        static_assert(std::is_base_of_v<Oscillator, O>, "class O must be derived from Oscillator");
+        static_assert(std::is_base_of_v<Envelope, E>, "class E must be derived from Envelope");
+        static_assert(!std::is_abstract_v<O> && !std::is_abstract_v<E>, "classes O and E must be concrete");
+
+        m_pitch_mod.freq(freq);
+    }
+
+    ~VoiceStatic() noexcept = default;
+
+    std::unique_ptr<Voice> clone() const override
+    {
+        return std::make_unique<VoiceStatic>(*this);
+    }
+
+    /**
+     * @brief Copy an envelope, which must be an E, since the voice calls it
+     * as one. Throws std::runtime_error otherwise.
+     */
+    void env(const Envelope& env) override
+    {
+        if (typeid(env) != typeid(E))
+        {
+            throw std::runtime_error("envelope type doesn't match the voice");
+        }
+
+        m_env = static_cast<const E&>(env);
+    }
+
+    E& env() override
+    {
+        return m_env;
+    }
+
+    const E& env() const override
+    {
+        return m_env;
+    }
+
+    void freq(float freq) override
+    {
+        m_freq = freq;
+        m_pitch_mod.freq(freq);
+    }
+
+    float freq() const override
+    {
+        return m_freq;
+    }
+
+    void vol(float vol) override
+    {
+        m_vol = vol;
+    }
+
+    void note_on(float freq) override
+    {
+        // Reset the phase unless the note was already on (to prevent clicks).
+        if (!is_on())
+        {
+            m_phase = 0;
+        }
+
+        m_freq = freq;
+        m_pitch_mod.note_on(freq);
+        m_env.E::trig(true);
+    }
+
+    void note_off() override
+    {
+        m_env.E::trig(false);
+    }
+
+    bool is_on() const override
+    {
+        return m_env.E::is_on();
+    }
+
+    void process(float sample_duration, float& output) override
+    {
+        float phase_increment = m_pitch_mod.is_active() ? m_pitch_mod.process(sample_duration) : sample_duration * m_freq;
+        output = m_vol * Oscillator::static_value_with_increment(m_osc, m_phase, phase_increment) * m_env.E::process(sample_duration);
+
+        // Propagate phase.
+        m_phase += phase_increment;
+        if (m_phase >= 1)
+        {
+            m_phase -= 1;
+        }
+    }
+
+    void process_block(float sample_duration, float* output, size_t frames) override
+    {
+        float env[Util::block_size_max];
+        float phase_increments[Util::block_size_max];
+        float phase_increment = sample_duration * m_freq;
+
+        for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+        {
+            size_t chunk = std::min(frames - offset, Util::block_size_max);
+            float* out = output + offset;
+
+            if (m_pitch_mod.is_active())
+            {
+                m_pitch_mod.process_block(sample_duration, phase_increments, chunk);
+                m_phase = Oscillator::static_process_block_modulated(m_osc, m_phase, phase_increments, out, chunk);
+            }
+            else
+            {
+                m_phase = Oscillator::static_process_block(m_osc, m_phase, phase_increment, out, chunk);
+            }
+            m_env.E::process_block(sample_duration, env, chunk);
+
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                out[i] = m_vol * out[i] * env[i];
+            }
+        }
+    }
+
+    void osc(const O& osc)
+    {
+        m_osc = osc;
+    }
+
+    O& osc()
+    {
+        return m_osc;
+    }
+
+    const O& osc() const
+    {
+        return m_osc;
+    }
+
+    /**
+     * @brief The voice's glide, pitch bend and vibrato.
+     */
+    PitchMod& pitch_mod()
+    {
+        return m_pitch_mod;
+    }
+
+    const PitchMod& pitch_mod() const
+    {
+        return m_pitch_mod;
+    }
+
+private:
+    O m_osc;
+    E m_env;
+    float m_freq;
+    float m_phase;
+    float m_vol;
+    PitchMod m_pitch_mod;
 };
 
 }
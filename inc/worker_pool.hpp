@@ -0,0 +1,90 @@
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include "denormals.hpp"
+#include "realtime_check.hpp"
+#include "util.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace MusicLib {
+
+/**
+ * @brief A persistent pool of worker threads that helps the audio thread
+ * run a batch of independent jobs, e.g. rendering instruments.
+ *
+ * While batches keep coming, the workers busy-wait for work instead of
+ * sleeping, so handing a batch over takes no system calls on the calling
+ * thread. After idling for a while, e.g. while the transport is stopped,
+ * they block instead, and the next batch wakes them. The calling thread
+ * takes part in the batch, and never waits for a worker that hasn't
+ * started on it yet, so a descheduled worker can't make the callback miss
+ * its deadline. Workers run each batch in the denormal mode and real-time
+ * scope of the calling thread.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * @param threads Number of worker threads, in addition to the calling
+     * thread.
+     * @param pin Pin each worker to its own CPU core (Linux only).
+     */
+    explicit WorkerPool(unsigned int threads, bool pin = true);
+    ~WorkerPool() noexcept;
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned int threads() const;
+    bool pinned() const;
+
+    /**
+     * @brief Call job(context, index) for every index in [0, count), spread
+     * over the workers and the calling thread. Returns once every call is
+     * done. Must only be called from one thread at a time.
+     */
+    void run(void (*job)(void*, size_t), void* context, size_t count);
+
+    template <typename F>
+    void run(F& func, size_t count)
+    {
+        run([](void* context, size_t index) { (*static_cast<F*>(context))(index); }, &func, count);
+    }
+
+private:
+    struct alignas(Util::cache_line_size) Worker
+    {
+        std::atomic<uint64_t> go{0};
+        std::atomic<uint64_t> state{0};
+        std::atomic<bool> sleeping{false};
+    };
+
+    void work(Worker& worker, unsigned int cpu);
+    void claim_jobs();
+
+private:
+    unsigned int m_threads;
+    bool m_pin;
+
+    std::unique_ptr<Worker[]> m_workers;
+    std::vector<std::thread> m_thread_handles;
+    std::atomic<bool> m_stop;
+
+    uint64_t m_generation;
+    void (*m_job)(void*, size_t);
+    void* m_context;
+    size_t m_count;
+    DenormalMode m_denormal_mode;
+    bool m_is_realtime;
+    alignas(Util::cache_line_size) std::atomic<size_t> m_next;
+};
+
+}
+
+#endif // WORKER_POOL_H_
@@ -0,0 +1,107 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace MusicLib {
+
+Arena::Arena(size_t block_size)
+: m_block_size{block_size}
+, m_blocks{}
+, m_next_block{0}
+, m_head{nullptr}
+, m_end{nullptr}
+, m_used{0}
+, m_finalizers{nullptr}
+{
+
+}
+
+Arena::~Arena() noexcept
+{
+    finalize();
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t head = (uintptr_t) m_head;
+    uintptr_t start = (head + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+    if (!m_head || start + size > (uintptr_t) m_end)
+    {
+        // A new block has room for the padding, whatever its alignment.
+        next_block(size + alignment - 1);
+        head = (uintptr_t) m_head;
+        start = (head + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    }
+
+    m_head = (std::byte*) (start + size);
+    return (void*) start;
+}
+
+void Arena::clear()
+{
+    finalize();
+
+    m_next_block = 0;
+    m_head = nullptr;
+    m_end = nullptr;
+    m_used = 0;
+}
+
+size_t Arena::size() const
+{
+    if (!m_head)
+    {
+        return m_used;
+    }
+
+    return m_used + (m_head - m_blocks[m_next_block - 1].data.get());
+}
+
+size_t Arena::capacity() const
+{
+    size_t capacity = 0;
+    for (const auto& block : m_blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void Arena::next_block(size_t min_size)
+{
+    if (m_head)
+    {
+        m_used += m_blocks[m_next_block - 1].size;
+    }
+
+    // Reuse a block kept from before the last clear if one is large enough.
+    // Ones that aren't stay unused until the next clear.
+    while (m_next_block < m_blocks.size() && m_blocks[m_next_block].size < min_size)
+    {
+        m_used += m_blocks[m_next_block].size;
+        ++m_next_block;
+    }
+
+    if (m_next_block == m_blocks.size())
+    {
+        size_t size = std::max(m_block_size, min_size);
+        m_blocks.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(size), size});
+    }
+
+    Block& block = m_blocks[m_next_block++];
+    m_head = block.data.get();
+    m_end = m_head + block.size;
+}
+
+void Arena::finalize()
+{
+    for (Finalizer* f = m_finalizers; f; f = f->next)
+    {
+        f->destroy(f->obj);
+    }
+    m_finalizers = nullptr;
+}
+
+}
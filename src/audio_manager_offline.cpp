@@ -0,0 +1,255 @@
+#include "audio_manager_offline.hpp"
+#include "denormals.hpp"
+#include "device.hpp"
+#include "realtime_check.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace MusicLib {
+
+// The largest number of frames whose size fits the 32-bit sizes of a stereo
+// 32-bit float WAV file's header.
+constexpr unsigned long wav_frames_max = (UINT32_MAX - 36) / (2 * sizeof(float));
+
+static void write_u16(std::ofstream& file, uint16_t value)
+{
+    char bytes[2] = {(char) (value & 0xff), (char) (value >> 8)};
+    file.write(bytes, 2);
+}
+
+static void write_u32(std::ofstream& file, uint32_t value)
+{
+    char bytes[4] = {
+        (char) (value & 0xff),
+        (char) ((value >> 8) & 0xff),
+        (char) ((value >> 16) & 0xff),
+        (char) (value >> 24)
+    };
+    file.write(bytes, 4);
+}
+
+/**
+ * @brief Write the header of a stereo 32-bit float WAV file. Called once
+ * with 0 frames to reserve the space and again once the length is known.
+ */
+static void write_wav_header(std::ofstream& file, unsigned int sample_rate, unsigned long frames)
+{
+    const uint16_t channels = 2;
+    const uint16_t bytes_per_sample = sizeof(float);
+    uint32_t data_size = frames * channels * bytes_per_sample;
+
+    file.write("RIFF", 4);
+    write_u32(file, 36 + data_size);
+    file.write("WAVE", 4);
+
+    file.write("fmt ", 4);
+    write_u32(file, 16);
+    write_u16(file, 3); // IEEE float
+    write_u16(file, channels);
+    write_u32(file, sample_rate);
+    write_u32(file, sample_rate * channels * bytes_per_sample);
+    write_u16(file, channels * bytes_per_sample);
+    write_u16(file, 8 * bytes_per_sample);
+
+    file.write("data", 4);
+    write_u32(file, data_size);
+}
+
+static void write_wav_samples(std::ofstream& file, const float* samples, size_t count)
+{
+    char bytes[4 * 2 * Util::block_size_max];
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &samples[i], sizeof(bits));
+
+        // WAV data is little-endian regardless of the host.
+        bytes[4 * i] = (char) (bits & 0xff);
+        bytes[4 * i + 1] = (char) ((bits >> 8) & 0xff);
+        bytes[4 * i + 2] = (char) ((bits >> 16) & 0xff);
+        bytes[4 * i + 3] = (char) (bits >> 24);
+    }
+
+    file.write(bytes, 4 * count);
+}
+
+AudioManagerOffline::AudioManagerOffline(unsigned int sample_rate, Sequencer& seq,
+    Device<InputNone, OutputStereo>& device, CommandStream& cmd_stream,
+    float tail, float max_duration, unsigned int buffer_size)
+: m_sample_rate{sample_rate}
+, m_buffer_size{std::clamp<unsigned int>(buffer_size, 1, Util::block_size_max)}
+, m_sample_duration{1.0f / sample_rate}
+, m_tail{tail}
+, m_max_duration{max_duration}
+, m_seq{seq}
+, m_device{device}
+, m_cmd_stream{cmd_stream}
+, m_filename{}
+, m_buffer{}
+, m_frames_rendered{0}
+, m_render_time{0}
+, m_running{false}
+{
+
+}
+
+void AudioManagerOffline::start()
+{
+    std::ofstream file;
+
+    if (!m_filename.empty())
+    {
+        file.open(m_filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("cannot open output file " + m_filename);
+        }
+        write_wav_header(file, m_sample_rate, 0);
+    }
+
+    m_buffer.clear();
+    m_frames_rendered = 0;
+    m_running = true;
+
+    unsigned long max_frames = m_max_duration * m_sample_rate;
+    if (file.is_open())
+    {
+        max_frames = std::min(max_frames, wav_frames_max);
+    }
+    unsigned long tail_frames = m_tail * m_sample_rate;
+    bool finished = false;
+
+    float left[Util::block_size_max];
+    float right[Util::block_size_max];
+    float interleaved[2 * Util::block_size_max];
+
+    auto start_time = std::chrono::steady_clock::now();
+    DenormalGuard denormal_guard{m_denormal_mode};
+
+    while (m_running && m_frames_rendered < max_frames)
+    {
+        // Render the spans between sequencer steps as whole blocks, so that
+        // steps stay sample-accurate.
+        size_t chunk = std::min({(unsigned long) m_buffer_size, max_frames - m_frames_rendered,
+            m_seq.samples_until_step()});
+        if (finished)
+        {
+            chunk = std::min<unsigned long>(chunk, tail_frames);
+        }
+
+        if (chunk == 0)
+        {
+            break;
+        }
+
+        {
+            // Storing the output allocates, but rendering it mustn't, as it
+            // would on the audio thread.
+            RealtimeCheck::Scope realtime_scope{};
+            m_device.process_block(m_sample_duration, left, right, chunk);
+        }
+
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            interleaved[2 * i] = left[i];
+            interleaved[2 * i + 1] = right[i];
+        }
+
+        if (file.is_open())
+        {
+            write_wav_samples(file, interleaved, 2 * chunk);
+            if (!file)
+            {
+                m_running = false;
+                throw std::runtime_error("cannot write output file " + m_filename);
+            }
+        }
+        else
+        {
+            m_buffer.insert(m_buffer.end(), interleaved, interleaved + 2 * chunk);
+        }
+
+        {
+            RealtimeCheck::Scope realtime_scope{};
+            m_seq.advance(chunk);
+        }
+        m_frames_rendered += chunk;
+
+        if (finished)
+        {
+            tail_frames -= chunk;
+        }
+        else if (m_cmd_stream.finished())
+        {
+            finished = true;
+        }
+    }
+
+    m_render_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    m_running = false;
+
+    if (file.is_open())
+    {
+        file.seekp(0);
+        write_wav_header(file, m_sample_rate, m_frames_rendered);
+        file.flush();
+        if (!file)
+        {
+            throw std::runtime_error("cannot write output file " + m_filename);
+        }
+    }
+}
+
+void AudioManagerOffline::stop()
+{
+    m_running = false;
+}
+
+unsigned int AudioManagerOffline::sample_rate()
+{
+    return m_sample_rate;
+}
+
+float AudioManagerOffline::sample_duration()
+{
+    return m_sample_duration;
+}
+
+void AudioManagerOffline::output_file(const std::string& filename)
+{
+    m_filename = filename;
+}
+
+const std::vector<float>& AudioManagerOffline::buffer() const
+{
+    return m_buffer;
+}
+
+unsigned long AudioManagerOffline::frames_rendered() const
+{
+    return m_frames_rendered;
+}
+
+double AudioManagerOffline::render_time() const
+{
+    return m_render_time;
+}
+
+double AudioManagerOffline::realtime_factor() const
+{
+    if (m_render_time <= 0)
+    {
+        return 0;
+    }
+
+    return m_frames_rendered / (double) m_sample_rate / m_render_time;
+}
+
+}
@@ -1,7 +1,11 @@
 #include "audio_manager_portaudio.hpp"
+#include "denormals.hpp"
 #include "device.hpp"
+#include "realtime_check.hpp"
+#include "util.hpp"
 
 #include <portaudio.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -16,13 +20,51 @@ static int portaudio_out_callback(const void *inputBuffer [[maybe_unused]],
     auto *data = (PortAudioDataOut*) userData;
     auto& seq = data->seq;
     auto& device = data->device;
+    auto* control = data->control;
+    DenormalGuard denormal_guard{data->denormal_mode};
+    RealtimeCheck::Scope realtime_scope{};
 
-    // Write interleaved audio data.
-    for(size_t i = 0; i < framesPerBuffer; i++)
+    float left[Util::block_size_max];
+    float right[Util::block_size_max];
+
+    // Render the spans between sequencer steps and control messages as
+    // whole blocks, so that both stay sample-accurate.
+    size_t offset = 0;
+    while (offset < framesPerBuffer)
     {
-        device.process(data->sample_duration, *out, *(out+1));
-        out += 2;
-        seq.tick();
+        if (control)
+        {
+            control->dispatch(seq);
+        }
+
+        size_t chunk = std::min({framesPerBuffer - offset, Util::block_size_max,
+            (size_t) seq.samples_until_step()});
+
+        if (control)
+        {
+            chunk = std::min(chunk, (size_t) control->samples_until_message());
+        }
+
+        // A message was posted after dispatching, and is already due.
+        if (chunk == 0)
+        {
+            continue;
+        }
+        device.process_block(data->sample_duration, left, right, chunk);
+
+        // Write interleaved audio data.
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            *out++ = left[i];
+            *out++ = right[i];
+        }
+
+        seq.advance(chunk);
+        if (control)
+        {
+            control->advance(chunk);
+        }
+        offset += chunk;
     }
 
     return 0;
@@ -38,30 +80,82 @@ static int portaudio_in_out_callback(const void *inputBuffer [[maybe_unused]],
     auto *data = (PortAudioDataInOut*) userData;
     auto& seq = data->seq;
     auto& device = data->device;
-
-    // Write interleaved audio data.
-    for(size_t i = 0; i < framesPerBuffer; i++)
+    auto* control = data->control;
+    DenormalGuard denormal_guard{data->denormal_mode};
+    RealtimeCheck::Scope realtime_scope{};
+
+    float in_left[Util::block_size_max];
+    float in_right[Util::block_size_max];
+    float out_left[Util::block_size_max];
+    float out_right[Util::block_size_max];
+
+    // Render the spans between sequencer steps and control messages as
+    // whole blocks, so that both stay sample-accurate.
+    size_t offset = 0;
+    while (offset < framesPerBuffer)
     {
-        device.process(data->sample_duration, *in, *(in+1), *out, *(out+1));
-        out += 2;
-        seq.tick();
+        if (control)
+        {
+            control->dispatch(seq);
+        }
+
+        size_t chunk = std::min({framesPerBuffer - offset, Util::block_size_max,
+            (size_t) seq.samples_until_step()});
+
+        if (control)
+        {
+            chunk = std::min(chunk, (size_t) control->samples_until_message());
+        }
+
+        // A message was posted after dispatching, and is already due.
+        if (chunk == 0)
+        {
+            continue;
+        }
+
+        // Read interleaved audio data.
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            in_left[i] = *in++;
+            in_right[i] = *in++;
+        }
+
+        device.process_block(data->sample_duration, in_left, in_right, out_left, out_right, chunk);
+
+        // Write interleaved audio data.
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            *out++ = out_left[i];
+            *out++ = out_right[i];
+        }
+
+        seq.advance(chunk);
+        if (control)
+        {
+            control->advance(chunk);
+        }
+        offset += chunk;
     }
 
     return 0;
 }
 
-PortAudioDataOut::PortAudioDataOut(Sequencer& seq_, Device<InputNone, OutputStereo>& device_, float sample_duration_)
+PortAudioDataOut::PortAudioDataOut(Sequencer& seq_, Device<InputNone, OutputStereo>& device_, float sample_duration_,
+    ControlQueue* control_)
 : seq{seq_}
 , device{device_}
 , sample_duration{sample_duration_}
+, control{control_}
 {
 
 }
 
-PortAudioDataInOut::PortAudioDataInOut(Sequencer& seq_, Device<InputStereo, OutputStereo>& device_, float sample_duration_)
+PortAudioDataInOut::PortAudioDataInOut(Sequencer& seq_, Device<InputStereo, OutputStereo>& device_, float sample_duration_,
+    ControlQueue* control_)
 : seq{seq_}
 , device{device_}
 , sample_duration{sample_duration_}
+, control{control_}
 {
 
 }
@@ -92,6 +186,7 @@ void AudioManagerPortAudio::start()
 {
     PaError err;
     PaStream* stream = m_stream.get();
+    m_callback_data.denormal_mode = m_denormal_mode;
 
     // Open an audio I/O stream.
     err = Pa_OpenDefaultStream(&stream, 0, 2, paFloat32, m_sample_rate,
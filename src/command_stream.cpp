@@ -3,59 +3,84 @@
 #include "device.hpp"
 
 namespace MusicLib {
-    
-CommandStreamBasic::CommandStreamBasic(bool looping)
-: m_commands{}
-, m_cursor{0}
-, m_looping{looping}
+
+CommandStorage::CommandStorage()
+: m_arena{}
+, m_commands{}
 {
 
 }
 
-CommandStreamBasic::CommandStreamBasic(std::vector<std::unique_ptr<Command>>& commands, bool looping)
-: m_commands{}
-, m_cursor{0}
-, m_looping{looping}
+CommandStorage::CommandStorage(const std::vector<std::unique_ptr<Command>>& commands)
+: m_arena{}
+, m_commands{}
 {
-    m_commands.reserve(commands.size());
+    reserve(commands.size());
 
     for (const auto& c : commands)
     {
-        m_commands.push_back(c->clone());
+        add(*c);
     }
 }
 
+void CommandStorage::add(const Command& command)
+{
+    own_arena();
+    m_commands.push_back(command.clone_into(*m_arena));
+}
 
-CommandStreamBasic::CommandStreamBasic(const CommandStreamBasic& other)
-: m_commands{}
-, m_cursor{other.m_cursor}
-, m_looping{other.m_looping}
+void CommandStorage::reserve(size_t size)
 {
-    m_commands.reserve(other.m_commands.size());
+    m_commands.reserve(size);
+}
 
-    for (const auto& c : other.m_commands)
+void CommandStorage::clear()
+{
+    m_commands.clear();
+
+    if (m_arena && m_arena.use_count() == 1)
+    {
+        m_arena->clear();
+    }
+    else
     {
-        m_commands.push_back(c->clone());
+        m_arena.reset();
     }
 }
 
-CommandStreamBasic& CommandStreamBasic::operator=(const CommandStreamBasic& other)
+void CommandStorage::own_arena()
 {
-    if (this != &other)
+    if (!m_arena)
     {
-        m_commands.clear();
-        m_commands.reserve(other.m_commands.size());
-        
-        for (const auto& c : other.m_commands)
+        m_arena = std::make_shared<Arena>();
+    }
+    else if (m_arena.use_count() > 1)
+    {
+        // Copy on write. Appending to the shared arena would be harmless to
+        // the other copies, but not if they append at the same time.
+        auto arena = std::make_shared<Arena>();
+        for (auto& c : m_commands)
         {
-            m_commands.push_back(c->clone());
+            c = c->clone_into(*arena);
         }
-
-        m_cursor = other.m_cursor;
-        m_looping = other.m_looping;
+        m_arena = std::move(arena);
     }
+}
+
+CommandStreamBasic::CommandStreamBasic(bool looping)
+: m_commands{}
+, m_cursor{0}
+, m_looping{looping}
+{
+
+}
+
+CommandStreamBasic::CommandStreamBasic(std::vector<std::unique_ptr<Command>>& commands, bool looping)
+: m_commands{commands}
+, m_cursor{0}
+, m_looping{looping}
+{
 
-    return *this;
 }
 
 Command* CommandStreamBasic::current() const
@@ -65,7 +90,7 @@ Command* CommandStreamBasic::current() const
         return nullptr;
     }
     
-    return m_commands[m_cursor].get();
+    return m_commands[m_cursor];
 }
 
 bool CommandStreamBasic::finished() const
@@ -105,7 +130,7 @@ void CommandStreamBasic::cursor(unsigned long cursor)
 
 void CommandStreamBasic::add(Command& command)
 {
-    m_commands.push_back(command.clone());
+    m_commands.add(command);
 }
 
 
@@ -122,55 +147,12 @@ CommandStreamInstrument::CommandStreamInstrument(IInstrument& ins, bool looping)
 }
 
 CommandStreamInstrument::CommandStreamInstrument(std::vector<std::unique_ptr<Command>>& commands, IInstrument& ins, bool looping)
-: m_commands{}
+: m_commands{commands}
 , m_cursor{0}
 , m_looping{looping}
 , m_ins{ins}
 {
-    m_commands.reserve(commands.size());
-
-    for (const auto& c : commands)
-    {
-        m_commands.push_back(c->clone());
-    }
-}
-
-CommandStreamInstrument::CommandStreamInstrument(const CommandStreamInstrument& other)
-: m_commands{}
-, m_cursor{other.m_cursor}
-, m_looping{other.m_looping}
-, m_ins{other.m_ins}
-{
-    m_commands.reserve(other.m_commands.size());
-
-    for (const auto& c : other.m_commands)
-    {
-        m_commands.push_back(c->clone());
-    }
-
-    m_cursor = other.m_cursor;
-    m_looping = other.m_looping;
-    m_ins = other.m_ins;
-}
-
-CommandStreamInstrument& CommandStreamInstrument::operator=(const CommandStreamInstrument& other)
-{
-    if (this != &other)
-    {
-        m_commands.clear();
-        m_commands.reserve(other.m_commands.size());
-        
-        for (const auto& c : other.m_commands)
-        {
-            m_commands.push_back(c->clone());
-        }
-
-        m_cursor = other.m_cursor;
-        m_looping = other.m_looping;
-        m_ins = other.m_ins;
-    }
 
-    return *this;
 }
 
 Command* CommandStreamInstrument::current() const
@@ -180,7 +162,7 @@ Command* CommandStreamInstrument::current() const
         return nullptr;
     }
 
-    return m_commands[m_cursor].get();
+    return m_commands[m_cursor];
 }
 
 
@@ -222,7 +204,7 @@ void CommandStreamInstrument::cursor(unsigned long cursor)
 
 void CommandStreamInstrument::add(Command& command)
 {
-    m_commands.push_back(command.clone());
+    m_commands.add(command);
 }
 
 void CommandStreamInstrument::instrument(IInstrument& ins)
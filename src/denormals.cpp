@@ -0,0 +1,105 @@
+#include "denormals.hpp"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MUSICLIB_DENORMALS_X86
+#include <xmmintrin.h>
+#endif
+
+namespace MusicLib {
+
+#if defined(MUSICLIB_DENORMALS_X86)
+
+// MXCSR bits: flush to zero and denormals are zero.
+constexpr uint64_t flush_bits = 0x8000 | 0x0040;
+
+static uint64_t get_control()
+{
+    return _mm_getcsr();
+}
+
+static void set_control(uint64_t control)
+{
+    _mm_setcsr((unsigned int) control);
+}
+
+#elif defined(__aarch64__)
+
+// FPCR bit: flush to zero, which covers both inputs and outputs.
+constexpr uint64_t flush_bits = 1 << 24;
+
+static uint64_t get_control()
+{
+    uint64_t control;
+    asm volatile("mrs %0, fpcr" : "=r"(control));
+    return control;
+}
+
+static void set_control(uint64_t control)
+{
+    asm volatile("msr fpcr, %0" : : "r"(control));
+}
+
+#else
+
+constexpr uint64_t flush_bits = 0;
+
+static uint64_t get_control()
+{
+    return 0;
+}
+
+static void set_control(uint64_t control [[maybe_unused]])
+{
+}
+
+#endif
+
+DenormalGuard::DenormalGuard(DenormalMode mode)
+: m_saved{0}
+, m_is_changed{false}
+{
+    if (mode == DenormalMode::Keep || flush_bits == 0)
+    {
+        return;
+    }
+
+    // Writing the control register stalls the pipeline, so skip it when
+    // the thread is already flushing, e.g. in nested guards.
+    m_saved = get_control();
+    if ((m_saved & flush_bits) != flush_bits)
+    {
+        set_control(m_saved | flush_bits);
+        m_is_changed = true;
+    }
+}
+
+DenormalGuard::~DenormalGuard() noexcept
+{
+    if (m_is_changed)
+    {
+        set_control(m_saved);
+    }
+}
+
+DenormalMode DenormalGuard::current()
+{
+    if (flush_bits != 0 && (get_control() & flush_bits) == flush_bits)
+    {
+        return DenormalMode::Flush;
+    }
+
+    return DenormalMode::Keep;
+}
+
+void DenormalGuard::set_thread_mode(DenormalMode mode)
+{
+    if (flush_bits == 0)
+    {
+        return;
+    }
+
+    uint64_t control = get_control();
+    set_control(mode == DenormalMode::Flush ? control | flush_bits : control & ~flush_bits);
+}
+
+}
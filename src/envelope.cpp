@@ -1,5 +1,8 @@
 #include "envelope.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace MusicLib {
 
 EnvelopeZero::EnvelopeZero()
@@ -28,6 +31,16 @@ float EnvelopeZero::process(float sample_duration [[maybe_unused]])
     return 0;
 }
 
+void EnvelopeZero::process_block(float sample_duration [[maybe_unused]], float* out, size_t frames)
+{
+    float level = m_is_on ? 1 : 0;
+
+    for (size_t i = 0; i < frames; ++i)
+    {
+        out[i] = level;
+    }
+}
+
 bool EnvelopeZero::is_on() const
 {
     return m_is_on;
@@ -39,6 +52,9 @@ void EnvelopeZero::set_retrigger(bool is_retrigger [[maybe_unused]])
 EnvelopeADSR::EnvelopeADSR(float attack, float decay, float sustain, float release, bool is_retrigger)
 : m_level{0}
 , m_level_raw{0}
+, m_stage_start{0}
+, m_stage_position{0}
+, m_slope{0}
 , m_attack{attack}
 , m_decay{decay}
 , m_sustain{sustain}
@@ -99,18 +115,18 @@ void EnvelopeADSR::trig(bool is_on)
 {
     if (is_on)
     {
-        m_stage = Stage::ATTACK;
-
         if (m_is_retrigger)
         {
             m_level = 0;
         }
+
+        start_stage(Stage::ATTACK);
     }
     else
     {
         if (m_stage != Stage::OFF)
         {
-            m_stage = Stage::RELEASE;
+            start_stage(Stage::RELEASE);
         }
     }
 }
@@ -121,52 +137,178 @@ float EnvelopeADSR::process(float sample_duration)
     {
         m_level_raw = 0;
         m_level = 0;
-    }    
-    else if (m_stage == Stage::ATTACK)
+    }
+    else if (m_stage == Stage::SUSTAIN)
     {
-        m_level_raw += sample_duration / m_attack;
+        // Do nothing
+    }
+    else
+    {
+        update_slope(sample_duration);
+        m_level_raw = ramp(++m_stage_position);
 
-        if (m_level_raw >= 1)
+        if (is_stage_over(m_level_raw))
         {
-            m_level_raw = 1;
-            m_stage = Stage::DECAY;
+            end_stage();
         }
 
-        // m_level = 2 * m_level_raw - m_level_raw * m_level_raw;
+        // Attack: m_level = 2 * m_level_raw - m_level_raw * m_level_raw;
+        // Decay, release: m_level = m_level_raw * m_level_raw;
     }
-    else if (m_stage == Stage::DECAY)
+
+    m_level = m_level_raw;
+
+    return m_level;
+}
+
+void EnvelopeADSR::process_block(float sample_duration, float* out, size_t frames)
+{
+    size_t i = 0;
+
+    while (i < frames)
     {
-        m_level_raw -= sample_duration / m_decay;
+        if (m_stage == Stage::OFF)
+        {
+            m_level_raw = 0;
+            m_level = 0;
+            std::fill(out + i, out + frames, 0.0f);
+            return;
+        }
+
+        if (m_stage == Stage::SUSTAIN)
+        {
+            m_level = m_level_raw;
+            std::fill(out + i, out + frames, m_level);
+            return;
+        }
+
+        // Fill the samples up to the one that ends the stage with the ramp,
+        // and let process() handle that one.
+        update_slope(sample_duration);
+        size_t n = samples_in_stage(frames - i);
+
+        for (size_t k = 0; k < n; ++k)
+        {
+            out[i + k] = ramp(m_stage_position + 1 + (int32_t) k);
+        }
 
-        if (m_level_raw <= m_sustain)
+        if (n > 0)
         {
-            m_level_raw = m_sustain;
-            m_stage = Stage::SUSTAIN;
+            m_stage_position += (int32_t) n;
+            m_level_raw = out[i + n - 1];
+            m_level = m_level_raw;
+            i += n;
         }
 
-        // m_level = m_level_raw * m_level_raw;
+        if (i < frames)
+        {
+            out[i++] = EnvelopeADSR::process(sample_duration);
+        }
     }
-    else if (m_stage == Stage::SUSTAIN)
+}
+
+void EnvelopeADSR::start_stage(Stage stage)
+{
+    m_stage = stage;
+    m_stage_start = m_level_raw;
+    m_stage_position = 0;
+    m_slope = 0;
+}
+
+void EnvelopeADSR::update_slope(float sample_duration)
+{
+    float slope;
+
+    if (m_stage == Stage::ATTACK)
     {
-        // Do nothing
-        
+        slope = sample_duration / m_attack;
+    }
+    else if (m_stage == Stage::DECAY)
+    {
+        slope = -(sample_duration / m_decay);
     }
-    else // Release
+    else
     {
-        m_level_raw -= sample_duration / m_release;
+        slope = -(sample_duration / m_release);
+    }
 
-        if (m_level_raw <= 0)
-        {
-            m_level_raw = 0;
-            m_stage = Stage::OFF;
-        }
+    // Start a new ramp from the current level if the sample rate or the
+    // stage's duration has changed.
+    if (slope != m_slope)
+    {
+        m_stage_start = m_level_raw;
+        m_stage_position = 0;
+        m_slope = slope;
+    }
+}
+
+float EnvelopeADSR::ramp(int32_t position) const
+{
+    return m_stage_start + (float) position * m_slope;
+}
 
-        // m_level = m_level_raw * m_level_raw;
+bool EnvelopeADSR::is_stage_over(float level) const
+{
+    if (m_stage == Stage::ATTACK)
+    {
+        return level >= 1;
     }
 
-    m_level = m_level_raw;
+    if (m_stage == Stage::DECAY)
+    {
+        return level <= m_sustain;
+    }
 
-    return m_level;
+    return level <= 0;
+}
+
+void EnvelopeADSR::end_stage()
+{
+    if (m_stage == Stage::ATTACK)
+    {
+        m_level_raw = 1;
+        start_stage(Stage::DECAY);
+    }
+    else if (m_stage == Stage::DECAY)
+    {
+        m_level_raw = m_sustain;
+        start_stage(Stage::SUSTAIN);
+    }
+    else
+    {
+        m_level_raw = 0;
+        start_stage(Stage::OFF);
+    }
+}
+
+size_t EnvelopeADSR::samples_in_stage(size_t frames) const
+{
+    // The ramp is monotonic, so find the first position that ends the
+    // stage: estimate it, then correct the estimate against the ramp itself.
+    float target = m_stage == Stage::ATTACK ? 1 : m_stage == Stage::DECAY ? m_sustain : 0;
+
+    double first = m_stage_position + 1.0;
+    double last = m_stage_position + (double) frames;
+    double estimate = std::ceil((target - m_stage_start) / (double) m_slope);
+    if (!(estimate >= first))
+    {
+        estimate = std::isnan(estimate) ? last + 1 : first;
+    }
+
+    int32_t begin = (int32_t) first;
+    int32_t end = (int32_t) std::min(estimate, last + 1);
+
+    while (end > begin && is_stage_over(ramp(end - 1)))
+    {
+        --end;
+    }
+
+    while (end <= (int32_t) last && !is_stage_over(ramp(end)))
+    {
+        ++end;
+    }
+
+    return end - begin;
 }
 
 bool EnvelopeADSR::is_on() const
@@ -179,4 +321,288 @@ void EnvelopeADSR::set_retrigger(bool is_retrigger)
     m_is_retrigger = is_retrigger;
 }
 
-}
\ No newline at end of file
+// The coefficient of a segment that takes the given number of samples to
+// go from 0 to 1, heading towards 1 + overshoot. It holds for any segment
+// whose target overshoots its end by the same share of its height, so the
+// caller scales the overshoot by the segment's height.
+static float exp_coefficient(float samples, float overshoot)
+{
+    if (samples <= 0)
+    {
+        return 0;
+    }
+
+    return std::exp(-std::log((1 + overshoot) / overshoot) / samples);
+}
+
+// Also catches NaN.
+static float clamp_overshoot(float overshoot)
+{
+    return overshoot > EnvelopeExp::overshoot_min ? overshoot : EnvelopeExp::overshoot_min;
+}
+
+EnvelopeExp::EnvelopeExp(float attack, float decay, float sustain, float release,
+    bool is_retrigger, float attack_overshoot, float decay_overshoot)
+: m_level{0}
+, m_attack{attack}
+, m_decay{decay}
+, m_sustain{sustain}
+, m_release{release}
+, m_attack_overshoot{clamp_overshoot(attack_overshoot)}
+, m_decay_overshoot{clamp_overshoot(decay_overshoot)}
+, m_sample_duration{0}
+, m_attack_segment{}
+, m_decay_segment{}
+, m_release_segment{}
+, m_release_level{0}
+, m_stage{Stage::OFF}
+, m_is_retrigger{is_retrigger}
+{
+
+}
+
+std::unique_ptr<Envelope> EnvelopeExp::clone() const
+{
+    return std::make_unique<EnvelopeExp>(*this);
+}
+
+float EnvelopeExp::attack() const
+{
+    return m_attack;
+}
+
+void EnvelopeExp::attack(float attack)
+{
+    m_attack = attack;
+    update_coefficients();
+}
+
+float EnvelopeExp::decay() const
+{
+    return m_decay;
+}
+
+void EnvelopeExp::decay(float decay)
+{
+    m_decay = decay;
+    update_coefficients();
+}
+
+float EnvelopeExp::sustain() const
+{
+    return m_sustain;
+}
+
+void EnvelopeExp::sustain(float sustain)
+{
+    m_sustain = sustain;
+    update_coefficients();
+}
+
+float EnvelopeExp::release() const
+{
+    return m_release;
+}
+
+void EnvelopeExp::release(float release)
+{
+    m_release = release;
+    update_coefficients();
+}
+
+float EnvelopeExp::attack_overshoot() const
+{
+    return m_attack_overshoot;
+}
+
+void EnvelopeExp::attack_overshoot(float overshoot)
+{
+    m_attack_overshoot = clamp_overshoot(overshoot);
+    update_coefficients();
+}
+
+float EnvelopeExp::decay_overshoot() const
+{
+    return m_decay_overshoot;
+}
+
+void EnvelopeExp::decay_overshoot(float overshoot)
+{
+    m_decay_overshoot = clamp_overshoot(overshoot);
+    update_coefficients();
+}
+
+void EnvelopeExp::update_coefficients()
+{
+    if (m_sample_duration <= 0)
+    {
+        return;
+    }
+
+    float coef = exp_coefficient(m_attack / m_sample_duration, m_attack_overshoot);
+    m_attack_segment = {(1 + m_attack_overshoot) * (1 - coef), coef};
+
+    // The targets overshoot by a share of each segment's height, so that the
+    // segments take the set times whatever the sustain level.
+    coef = exp_coefficient(m_decay / m_sample_duration, m_decay_overshoot);
+    m_decay_segment = {(m_sustain - m_decay_overshoot * (1 - m_sustain)) * (1 - coef), coef};
+
+    update_release_segment();
+}
+
+void EnvelopeExp::update_release_segment()
+{
+    if (m_sample_duration <= 0)
+    {
+        return;
+    }
+
+    float coef = exp_coefficient(m_release / m_sample_duration, m_decay_overshoot);
+    m_release_segment = {-m_decay_overshoot * m_release_level * (1 - coef), coef};
+}
+
+void EnvelopeExp::trig(bool is_on)
+{
+    if (is_on)
+    {
+        m_stage = Stage::ATTACK;
+
+        if (m_is_retrigger)
+        {
+            m_level = 0;
+        }
+    }
+    else
+    {
+        if (m_stage != Stage::OFF)
+        {
+            m_stage = Stage::RELEASE;
+            m_release_level = m_level;
+            update_release_segment();
+        }
+    }
+}
+
+float EnvelopeExp::process(float sample_duration)
+{
+    if (sample_duration != m_sample_duration)
+    {
+        m_sample_duration = sample_duration;
+        update_coefficients();
+    }
+
+    float out;
+
+    switch (m_stage)
+    {
+    case Stage::OFF:
+        m_level = 0;
+        return 0;
+
+    case Stage::SUSTAIN:
+        return m_level;
+
+    case Stage::ATTACK:
+        render<Stage::ATTACK>(&out, 1);
+        return out;
+
+    case Stage::DECAY:
+        render<Stage::DECAY>(&out, 1);
+        return out;
+
+    case Stage::RELEASE:
+        render<Stage::RELEASE>(&out, 1);
+        return out;
+    }
+
+    return 0;
+}
+
+void EnvelopeExp::process_block(float sample_duration, float* out, size_t frames)
+{
+    if (sample_duration != m_sample_duration)
+    {
+        m_sample_duration = sample_duration;
+        update_coefficients();
+    }
+
+    size_t i = 0;
+
+    while (i < frames)
+    {
+        switch (m_stage)
+        {
+        case Stage::OFF:
+            m_level = 0;
+            std::fill(out + i, out + frames, 0.0f);
+            return;
+
+        case Stage::SUSTAIN:
+            std::fill(out + i, out + frames, m_level);
+            return;
+
+        case Stage::ATTACK:
+            i += render<Stage::ATTACK>(out + i, frames - i);
+            break;
+
+        case Stage::DECAY:
+            i += render<Stage::DECAY>(out + i, frames - i);
+            break;
+
+        case Stage::RELEASE:
+            i += render<Stage::RELEASE>(out + i, frames - i);
+            break;
+        }
+    }
+}
+
+template <EnvelopeExp::Stage S>
+size_t EnvelopeExp::render(float* out, size_t frames)
+{
+    const Segment& segment = S == Stage::ATTACK ? m_attack_segment
+        : S == Stage::DECAY ? m_decay_segment
+        : m_release_segment;
+
+    float base = segment.base;
+    float coef = segment.coef;
+    float level = m_level;
+
+    // Run the segment until it reaches its end, or the block does.
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float previous = level;
+        level = base + level * coef;
+
+        // A segment also ends once the level stops changing, which happens
+        // short of its end with small overshoots and long segments, as the
+        // steps fall below float precision.
+        bool is_over = (S == Stage::ATTACK ? level >= 1
+            : S == Stage::DECAY ? level <= m_sustain
+            : level <= 0) || level == previous;
+
+        if (is_over)
+        {
+            m_level = S == Stage::ATTACK ? 1 : S == Stage::DECAY ? m_sustain : 0;
+            m_stage = S == Stage::ATTACK ? Stage::DECAY : S == Stage::DECAY ? Stage::SUSTAIN : Stage::OFF;
+            out[i] = m_level;
+            return i + 1;
+        }
+
+        out[i] = level;
+    }
+
+    m_level = level;
+    return frames;
+}
+
+bool EnvelopeExp::is_on() const
+{
+    return m_stage != Stage::OFF;
+}
+
+void EnvelopeExp::set_retrigger(bool is_retrigger)
+{
+    m_is_retrigger = is_retrigger;
+}
+
+}
@@ -0,0 +1,107 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MusicLib {
+
+MappedFile::MappedFile(const std::string& filename, bool sequential)
+: m_data{nullptr}
+, m_size{0}
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("cannot open " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("cannot open " + filename);
+    }
+
+    // Empty mappings aren't allowed.
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("cannot map " + filename);
+    }
+
+    m_data = static_cast<const std::byte*>(data);
+    m_size = st.st_size;
+
+    if (sequential)
+    {
+        madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: m_data{other.m_data}
+, m_size{other.m_size}
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        m_data = other.m_data;
+        m_size = other.m_size;
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    return *this;
+}
+
+const std::byte* MappedFile::data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+std::string_view MappedFile::text() const
+{
+    return {reinterpret_cast<const char*>(m_data), m_size};
+}
+
+void MappedFile::unmap()
+{
+    if (m_data)
+    {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+}
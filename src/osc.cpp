@@ -1,5 +1,11 @@
 #include "osc.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <numbers>
 #include <memory>
 #include <vector>
 #include <iostream>
@@ -31,10 +37,81 @@ float osc_triangle(float phase)
     return 3 - 4 * phase;
 }
 
+float osc_pulse(float phase, float pulsewidth)
+{
+    if (phase < pulsewidth)
+    {
+        return 1;
+    }
+
+    return -1;
+}
+
+float osc_wavetable(float phase, const float* wavetable, size_t size, bool antialiasing)
+{
+    float phase_rescaled = phase * size;
+    int index = (int)phase_rescaled;
+
+    if (!antialiasing)
+    {
+        return wavetable[index];
+    }
+
+    // Linear antialiasing
+    float res = phase_rescaled - index;
+
+    float p1 = wavetable[index];
+    float p2 = wavetable[(int)(phase_rescaled + 1) % size];
+    return p1 * (1.0f - res) + p2 * res;
+}
+
+float osc_table(float phase, const float* table, size_t size, Interpolation interpolation)
+{
+    float phase_rescaled = phase * size;
+    int index = (int)phase_rescaled;
+    float res = phase_rescaled - index;
+
+    // The guard points make the neighbours of every point valid, and the
+    // mask only wraps a phase that rounded up to the table length.
+    const float* p = table + (index & (size - 1));
+
+    switch (interpolation)
+    {
+    case Interpolation::None:
+        return p[0];
+
+    case Interpolation::Linear:
+        return p[0] + res * (p[1] - p[0]);
+
+    case Interpolation::Cubic:
+        break;
+    }
+
+    // 4-point, 3rd-order Hermite
+    float c1 = .5f * (p[1] - p[-1]);
+    float c2 = p[-1] - 2.5f * p[0] + 2 * p[1] - .5f * p[2];
+    float c3 = .5f * (p[2] - p[-1]) + 1.5f * (p[0] - p[1]);
+    return ((c3 * res + c2) * res + c1) * res + p[0];
+}
+
 OscillatorBasic::OscillatorBasic(std::function<float(float)> osc_func)
 : m_osc_func{osc_func}
+, m_osc_values{nullptr}
 {
+    auto func = m_osc_func.target<float(*)(float)>();
 
+    if (func && *func == osc_saw)
+    {
+        m_osc_values = osc_saw_values;
+    }
+    else if (func && *func == osc_square)
+    {
+        m_osc_values = osc_square_values;
+    }
+    else if (func && *func == osc_triangle)
+    {
+        m_osc_values = osc_triangle_values;
+    }
 }
 
 std::unique_ptr<Oscillator> OscillatorBasic::clone() const
@@ -48,6 +125,20 @@ float OscillatorBasic::value(float phase) const
     return m_osc_func(phase);
 }
 
+void OscillatorBasic::values(const float* phases, float* out, size_t n) const
+{
+    if (m_osc_values)
+    {
+        m_osc_values(phases, out, n);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = m_osc_func(phases[i]);
+    }
+}
+
 OscillatorPulse::OscillatorPulse(float pulsewidth)
 : m_pulsewidth{pulsewidth}
 {
@@ -62,12 +153,12 @@ std::unique_ptr<Oscillator> OscillatorPulse::clone() const
 
 float OscillatorPulse::value(float phase) const
 {
-    if (phase < m_pulsewidth)
-    {
-        return 1;
-    }
+    return osc_pulse(phase, m_pulsewidth);
+}
 
-    return -1;
+void OscillatorPulse::values(const float* phases, float* out, size_t n) const
+{
+    osc_pulse_values(phases, out, n, m_pulsewidth);
 }
 
 OscillatorWavetable::OscillatorWavetable(std::vector<float> wavetable, bool antialiasing)
@@ -84,20 +175,494 @@ std::unique_ptr<Oscillator> OscillatorWavetable::clone() const
 
 float OscillatorWavetable::value(float phase) const
 {
-    float phase_rescaled = phase * m_wavetable.size();
-    int index = (int)phase_rescaled;
+    return osc_wavetable(phase, m_wavetable.data(), m_wavetable.size(), m_antialiasing);
+}
+
+void OscillatorWavetable::values(const float* phases, float* out, size_t n) const
+{
+    osc_wavetable_values(phases, out, n, m_wavetable.data(), m_wavetable.size(), m_antialiasing);
+}
 
-    if (!m_antialiasing)
+// The residual of a step from 1 to -1 band-limited with a two-sample
+// polynomial, for a step at phase 0. Zero outside of one increment around
+// the step.
+static inline float poly_blep(float phase, float phase_increment)
+{
+    if (phase < phase_increment)
     {
-        return m_wavetable[index];
+        float x = phase / phase_increment;
+        return x + x - x * x - 1;
     }
 
-    // Linear antialiasing
-    float res = phase_rescaled - index;
+    if (phase > 1 - phase_increment)
+    {
+        float x = (phase - 1) / phase_increment;
+        return x * x + x + x + 1;
+    }
 
-    float p1 = m_wavetable[index];
-    float p2 = m_wavetable[(int)(phase_rescaled + 1) % m_wavetable.size()];
-    return p1 * (1.0f - res) + p2 * res;
+    return 0;
+}
+
+// The integral of poly_blep, for a change of slope of 2 per sample at phase 0.
+static inline float poly_blamp(float phase, float phase_increment)
+{
+    if (phase < phase_increment)
+    {
+        float x = phase / phase_increment - 1;
+        return -x * x * x / 3;
+    }
+
+    if (phase > 1 - phase_increment)
+    {
+        float x = (phase - 1) / phase_increment + 1;
+        return x * x * x / 3;
+    }
+
+    return 0;
+}
+
+// The phase relative to a discontinuity at the given offset.
+static inline float phase_from(float phase, float offset)
+{
+    phase -= offset;
+    if (phase < 0)
+    {
+        phase += 1;
+    }
+
+    return phase;
+}
+
+template <OscillatorPolyBLEP::Shape S>
+static inline float poly_blep_value(float phase, float phase_increment, float pulsewidth [[maybe_unused]])
+{
+    // The corrections assume at most one discontinuity per sample.
+    phase_increment = std::min(phase_increment, .5f);
+
+    if constexpr (S == OscillatorPolyBLEP::Shape::Saw)
+    {
+        return osc_saw(phase) - poly_blep(phase, phase_increment);
+    }
+    else if constexpr (S == OscillatorPolyBLEP::Shape::Square)
+    {
+        return osc_square(phase)
+            - poly_blep(phase, phase_increment)
+            + poly_blep(phase_from(phase, .5), phase_increment);
+    }
+    else if constexpr (S == OscillatorPolyBLEP::Shape::Triangle)
+    {
+        // The slope changes by 8 per cycle at each corner, which is
+        // 8 * phase_increment per sample, or 4 * phase_increment times the
+        // change poly_blamp is scaled for.
+        return osc_triangle(phase)
+            + 4 * phase_increment * (poly_blamp(phase, phase_increment)
+                - poly_blamp(phase_from(phase, .5), phase_increment));
+    }
+    else
+    {
+        return osc_pulse(phase, pulsewidth)
+            + poly_blep(phase, phase_increment)
+            - poly_blep(phase_from(phase, pulsewidth), phase_increment);
+    }
+}
+
+OscillatorPolyBLEP::OscillatorPolyBLEP(Shape shape, float pulsewidth)
+: m_shape{shape}
+, m_pulsewidth{pulsewidth}
+{
+
+}
+
+std::unique_ptr<Oscillator> OscillatorPolyBLEP::clone() const
+{
+    return std::make_unique<OscillatorPolyBLEP>(*this);
+}
+
+float OscillatorPolyBLEP::value(float phase) const
+{
+    return value_with_increment(phase, 0);
+}
+
+float OscillatorPolyBLEP::value_with_increment(float phase, float phase_increment) const
+{
+    switch (m_shape)
+    {
+    case Shape::Saw:
+        return poly_blep_value<Shape::Saw>(phase, phase_increment, m_pulsewidth);
+
+    case Shape::Square:
+        return poly_blep_value<Shape::Square>(phase, phase_increment, m_pulsewidth);
+
+    case Shape::Triangle:
+        return poly_blep_value<Shape::Triangle>(phase, phase_increment, m_pulsewidth);
+
+    case Shape::Pulse:
+        return poly_blep_value<Shape::Pulse>(phase, phase_increment, m_pulsewidth);
+    }
+
+    return 0;
+}
+
+float OscillatorPolyBLEP::process_block(float phase, float phase_increment, float* out, size_t frames) const
+{
+    switch (m_shape)
+    {
+    case Shape::Saw:
+        return render<Shape::Saw>(phase, phase_increment, out, frames);
+
+    case Shape::Square:
+        return render<Shape::Square>(phase, phase_increment, out, frames);
+
+    case Shape::Triangle:
+        return render<Shape::Triangle>(phase, phase_increment, out, frames);
+
+    case Shape::Pulse:
+        return render<Shape::Pulse>(phase, phase_increment, out, frames);
+    }
+
+    return phase;
+}
+
+template <OscillatorPolyBLEP::Shape S>
+float OscillatorPolyBLEP::render(float phase, float phase_increment, float* out, size_t frames) const
+{
+    for (size_t i = 0; i < frames; ++i)
+    {
+        out[i] = poly_blep_value<S>(phase, phase_increment, m_pulsewidth);
+
+        phase += phase_increment;
+        if (phase >= 1)
+        {
+            phase -= 1;
+        }
+    }
+
+    return phase;
+}
+
+float OscillatorPolyBLEP::process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const
+{
+    switch (m_shape)
+    {
+    case Shape::Saw:
+        return render_modulated<Shape::Saw>(phase, phase_increments, out, frames);
+
+    case Shape::Square:
+        return render_modulated<Shape::Square>(phase, phase_increments, out, frames);
+
+    case Shape::Triangle:
+        return render_modulated<Shape::Triangle>(phase, phase_increments, out, frames);
+
+    case Shape::Pulse:
+        return render_modulated<Shape::Pulse>(phase, phase_increments, out, frames);
+    }
+
+    return phase;
 }
 
-}
\ No newline at end of file
+template <OscillatorPolyBLEP::Shape S>
+float OscillatorPolyBLEP::render_modulated(float phase, const float* phase_increments, float* out, size_t frames) const
+{
+    for (size_t i = 0; i < frames; ++i)
+    {
+        out[i] = poly_blep_value<S>(phase, phase_increments[i], m_pulsewidth);
+
+        phase += phase_increments[i];
+        if (phase >= 1)
+        {
+            phase -= 1;
+        }
+    }
+
+    return phase;
+}
+
+void OscillatorPolyBLEP::shape(Shape shape)
+{
+    m_shape = shape;
+}
+
+OscillatorPolyBLEP::Shape OscillatorPolyBLEP::shape() const
+{
+    return m_shape;
+}
+
+void OscillatorPolyBLEP::pulsewidth(float pulsewidth)
+{
+    m_pulsewidth = pulsewidth;
+}
+
+float OscillatorPolyBLEP::pulsewidth() const
+{
+    return m_pulsewidth;
+}
+
+// In-place radix-2 FFT. The length of data must be a power of two. The
+// inverse transform isn't normalized.
+static void fft(std::vector<std::complex<double>>& data, bool inverse)
+{
+    size_t n = data.size();
+
+    for (size_t i = 1, j = 0; i < n; ++i)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j)
+        {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+        double angle = 2 * std::numbers::pi / len * (inverse ? 1 : -1);
+        std::complex<double> step = std::polar(1.0, angle);
+
+        for (size_t i = 0; i < n; i += len)
+        {
+            std::complex<double> w = 1;
+            for (size_t j = 0; j < len / 2; ++j)
+            {
+                std::complex<double> u = data[i + j];
+                std::complex<double> v = data[i + j + len / 2] * w;
+                data[i + j] = u + v;
+                data[i + j + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+// The first harmonics of a table, as given by its DFT.
+static std::vector<std::complex<double>> harmonics(const std::vector<float>& table, size_t count)
+{
+    size_t n = table.size();
+    std::vector<std::complex<double>> result(count);
+
+    if (std::has_single_bit(n))
+    {
+        std::vector<std::complex<double>> data(table.begin(), table.end());
+        fft(data, false);
+        std::copy_n(data.begin(), count, result.begin());
+        return result;
+    }
+
+    for (size_t h = 0; h < count; ++h)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            result[h] += std::polar((double) table[i], -2 * std::numbers::pi * h * i / n);
+        }
+    }
+
+    return result;
+}
+
+OscillatorWavetableMipmap::OscillatorWavetableMipmap(const std::vector<float>& wavetable,
+    Interpolation interpolation, bool crossfade)
+: m_tables{}
+, m_size{std::bit_ceil(std::max<size_t>(wavetable.size(), 2))}
+, m_levels{0}
+, m_interpolation{interpolation}
+, m_crossfade{crossfade}
+{
+    if (wavetable.empty())
+    {
+        throw std::invalid_argument("wavetable is empty");
+    }
+
+    // Level k keeps the harmonics up to m_size / 2^(k + 1), excluding the
+    // Nyquist frequency of the table itself, down to a single harmonic.
+    m_levels = std::bit_width(m_size) - 1;
+    size_t max_harmonic = std::min(wavetable.size() / 2, m_size / 2 - 1);
+    if (wavetable.size() % 2 == 0 && max_harmonic == wavetable.size() / 2)
+    {
+        max_harmonic -= 1;
+    }
+
+    auto source = harmonics(wavetable, max_harmonic + 1);
+    double scale = (double) m_size / wavetable.size();
+
+    size_t stride = guard_before + m_size + guard_after;
+    m_tables.resize(stride * m_levels);
+
+    std::vector<std::complex<double>> spectrum(m_size);
+    for (size_t k = 0; k < m_levels; ++k)
+    {
+        size_t top = std::min(max_harmonic, m_size >> (k + 1));
+
+        std::fill(spectrum.begin(), spectrum.end(), 0);
+        spectrum[0] = source[0] * scale;
+        for (size_t h = 1; h <= top; ++h)
+        {
+            spectrum[h] = source[h] * scale;
+            spectrum[m_size - h] = std::conj(spectrum[h]);
+        }
+
+        fft(spectrum, true);
+
+        float* table = m_tables.data() + k * stride + guard_before;
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            table[i] = spectrum[i].real() / m_size;
+        }
+
+        table[-1] = table[m_size - 1];
+        table[m_size] = table[0];
+        table[m_size + 1] = table[1 % m_size];
+    }
+}
+
+std::unique_ptr<Oscillator> OscillatorWavetableMipmap::clone() const
+{
+    return std::make_unique<OscillatorWavetableMipmap>(*this);
+}
+
+float OscillatorWavetableMipmap::value(float phase) const
+{
+    return value_with_increment(phase, 0);
+}
+
+float OscillatorWavetableMipmap::value_with_increment(float phase, float phase_increment) const
+{
+    float position;
+    size_t index = select_level(phase_increment, position);
+
+    float out = osc_table(phase, level(index), m_size, m_interpolation);
+
+    if (position == 0)
+    {
+        return out;
+    }
+
+    float next = osc_table(phase, level(index + 1), m_size, m_interpolation);
+    return out + position * (next - out);
+}
+
+void OscillatorWavetableMipmap::values(const float* phases, float* out, size_t n) const
+{
+    values_with_increment(phases, out, n, 0);
+}
+
+float OscillatorWavetableMipmap::process_block(float phase, float phase_increment, float* out, size_t frames) const
+{
+    float phases[Util::block_size_max];
+
+    for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+    {
+        size_t chunk = std::min(frames - offset, Util::block_size_max);
+
+        phase = phase_ramp(phase, phase_increment, phases, chunk);
+        values_with_increment(phases, out + offset, chunk, phase_increment);
+    }
+
+    return phase;
+}
+
+float OscillatorWavetableMipmap::process_block_modulated(float phase, const float* phase_increments, float* out, size_t frames) const
+{
+    float phases[Util::block_size_max];
+
+    for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+    {
+        size_t chunk = std::min(frames - offset, Util::block_size_max);
+        const float* increments = phase_increments + offset;
+
+        phase = phase_ramp(phase, increments, phases, chunk);
+        values_with_increment(phases, out + offset, chunk, *std::max_element(increments, increments + chunk));
+    }
+
+    return phase;
+}
+
+void OscillatorWavetableMipmap::values_with_increment(const float* phases, float* out, size_t n, float phase_increment) const
+{
+    float position;
+    size_t index = select_level(phase_increment, position);
+
+    osc_table_values(phases, out, n, level(index), m_size, m_interpolation);
+
+    if (position == 0)
+    {
+        return;
+    }
+
+    float next[Util::block_size_max];
+
+    for (size_t offset = 0; offset < n; offset += Util::block_size_max)
+    {
+        size_t chunk = std::min(n - offset, Util::block_size_max);
+        osc_table_values(phases + offset, next, chunk, level(index + 1), m_size, m_interpolation);
+
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            out[offset + i] += position * (next[i] - out[offset + i]);
+        }
+    }
+}
+
+size_t OscillatorWavetableMipmap::select_level(float phase_increment, float& position) const
+{
+    // The harmonics of level k fit under the Nyquist frequency as long as
+    // phase_increment * m_size <= 2^k. Split that product into an octave
+    // and a position within the octave, which is 0 at its bottom and
+    // approaches 1 at its top, straight from its exponent and mantissa.
+    uint32_t bits = std::bit_cast<uint32_t>(phase_increment * m_size);
+    int octave = (int)((bits >> 23) & 0xff) - 126;
+    size_t index = std::clamp(octave, 0, (int) m_levels - 1);
+
+    // Fade into the next level along the octave, so that the level has
+    // fully faded out when its top harmonic reaches the Nyquist frequency.
+    if (m_crossfade && octave >= 0 && index + 1 < m_levels)
+    {
+        position = std::bit_cast<float>((bits & 0x7fffff) | 0x3f800000) - 1;
+    }
+    else
+    {
+        position = 0;
+    }
+
+    return index;
+}
+
+const float* OscillatorWavetableMipmap::level(size_t index) const
+{
+    return m_tables.data() + index * (guard_before + m_size + guard_after) + guard_before;
+}
+
+void OscillatorWavetableMipmap::interpolation(Interpolation interpolation)
+{
+    m_interpolation = interpolation;
+}
+
+Interpolation OscillatorWavetableMipmap::interpolation() const
+{
+    return m_interpolation;
+}
+
+void OscillatorWavetableMipmap::crossfade(bool crossfade)
+{
+    m_crossfade = crossfade;
+}
+
+bool OscillatorWavetableMipmap::crossfade() const
+{
+    return m_crossfade;
+}
+
+size_t OscillatorWavetableMipmap::size() const
+{
+    return m_size;
+}
+
+size_t OscillatorWavetableMipmap::levels() const
+{
+    return m_levels;
+}
+
+}
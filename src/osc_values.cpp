@@ -0,0 +1,476 @@
+#include "osc.hpp"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MUSICLIB_OSC_X86
+#include <immintrin.h>
+#endif
+
+namespace MusicLib {
+
+#ifdef MUSICLIB_OSC_X86
+
+// The SSE2 kernels work on 4 phases at a time, and are always available on
+// the targets they're compiled for. The AVX2 kernels work on 8 phases at a
+// time, and are only called if the CPU running the library supports them.
+// Both follow the scalar functions operation by operation, so the results
+// are identical, and leave the remainder of the batch to them.
+
+static bool cpu_has_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static const bool has_avx2 = cpu_has_avx2();
+
+// SSE2 has no blend instruction.
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static size_t saw_sse2(const float* phases, float* out, size_t n)
+{
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 two = _mm_set1_ps(2);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 phase = _mm_loadu_ps(phases + i);
+        _mm_storeu_ps(out + i, _mm_sub_ps(_mm_mul_ps(two, phase), one));
+    }
+
+    return i;
+}
+
+static size_t square_sse2(const float* phases, float* out, size_t n)
+{
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(.5f);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 low = _mm_cmplt_ps(_mm_loadu_ps(phases + i), half);
+        _mm_storeu_ps(out + i, _mm_or_ps(one, _mm_and_ps(low, sign)));
+    }
+
+    return i;
+}
+
+static size_t triangle_sse2(const float* phases, float* out, size_t n)
+{
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 three = _mm_set1_ps(3);
+    const __m128 four = _mm_set1_ps(4);
+    const __m128 half = _mm_set1_ps(.5f);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 phase = _mm_loadu_ps(phases + i);
+        __m128 scaled = _mm_mul_ps(four, phase);
+        __m128 rising = _mm_sub_ps(scaled, one);
+        __m128 falling = _mm_sub_ps(three, scaled);
+        _mm_storeu_ps(out + i, select(_mm_cmplt_ps(phase, half), rising, falling));
+    }
+
+    return i;
+}
+
+static size_t pulse_sse2(const float* phases, float* out, size_t n, float pulsewidth)
+{
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 width = _mm_set1_ps(pulsewidth);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        // Not less-than rather than greater-or-equal, so that a NaN phase
+        // gives -1 like the scalar version.
+        __m128 high = _mm_cmpnlt_ps(_mm_loadu_ps(phases + i), width);
+        _mm_storeu_ps(out + i, _mm_or_ps(one, _mm_and_ps(high, sign)));
+    }
+
+    return i;
+}
+
+static size_t wavetable_sse2(const float* phases, float* out, size_t n,
+    const float* wavetable, size_t size, bool antialiasing)
+{
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 size_f = _mm_set1_ps(size);
+    const __m128i size_i = _mm_set1_epi32(size);
+    const __m128i last_i = _mm_set1_epi32(size - 1);
+
+    alignas(16) int32_t index[4];
+    alignas(16) int32_t next[4];
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 phase_rescaled = _mm_mul_ps(_mm_loadu_ps(phases + i), size_f);
+        __m128i index_i = _mm_cvttps_epi32(phase_rescaled);
+        _mm_store_si128((__m128i*) index, index_i);
+
+        // SSE2 has no gather instruction.
+        __m128 p1 = _mm_setr_ps(wavetable[index[0]], wavetable[index[1]],
+            wavetable[index[2]], wavetable[index[3]]);
+
+        if (!antialiasing)
+        {
+            _mm_storeu_ps(out + i, p1);
+            continue;
+        }
+
+        __m128 res = _mm_sub_ps(phase_rescaled, _mm_cvtepi32_ps(index_i));
+
+        // The following index, wrapped around the end of the table.
+        __m128i next_i = _mm_cvttps_epi32(_mm_add_ps(phase_rescaled, one));
+        __m128i wraps = _mm_cmpgt_epi32(next_i, last_i);
+        next_i = _mm_sub_epi32(next_i, _mm_and_si128(wraps, size_i));
+        _mm_store_si128((__m128i*) next, next_i);
+
+        __m128 p2 = _mm_setr_ps(wavetable[next[0]], wavetable[next[1]],
+            wavetable[next[2]], wavetable[next[3]]);
+
+        __m128 value = _mm_add_ps(_mm_mul_ps(p1, _mm_sub_ps(one, res)), _mm_mul_ps(p2, res));
+        _mm_storeu_ps(out + i, value);
+    }
+
+    return i;
+}
+
+template <Interpolation I>
+static size_t table_sse2(const float* phases, float* out, size_t n, const float* table, size_t size)
+{
+    const __m128 size_f = _mm_set1_ps(size);
+    const __m128i mask = _mm_set1_epi32(size - 1);
+
+    alignas(16) int32_t index[4];
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 phase_rescaled = _mm_mul_ps(_mm_loadu_ps(phases + i), size_f);
+        __m128i index_i = _mm_cvttps_epi32(phase_rescaled);
+        __m128 res = _mm_sub_ps(phase_rescaled, _mm_cvtepi32_ps(index_i));
+        _mm_store_si128((__m128i*) index, _mm_and_si128(index_i, mask));
+
+        if constexpr (I == Interpolation::None)
+        {
+            _mm_storeu_ps(out + i, _mm_setr_ps(table[index[0]], table[index[1]],
+                table[index[2]], table[index[3]]));
+            continue;
+        }
+
+        // Load the neighbourhood of each lane's point, and transpose them
+        // into one vector per neighbour.
+        __m128 pm1 = _mm_loadu_ps(table + index[0] - 1);
+        __m128 p0 = _mm_loadu_ps(table + index[1] - 1);
+        __m128 p1 = _mm_loadu_ps(table + index[2] - 1);
+        __m128 p2 = _mm_loadu_ps(table + index[3] - 1);
+        _MM_TRANSPOSE4_PS(pm1, p0, p1, p2);
+
+        __m128 value;
+        if constexpr (I == Interpolation::Linear)
+        {
+            value = _mm_add_ps(p0, _mm_mul_ps(res, _mm_sub_ps(p1, p0)));
+        }
+        else
+        {
+            __m128 c1 = _mm_mul_ps(_mm_set1_ps(.5f), _mm_sub_ps(p1, pm1));
+            __m128 c2 = _mm_sub_ps(pm1, _mm_mul_ps(_mm_set1_ps(2.5f), p0));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_set1_ps(2), p1));
+            c2 = _mm_sub_ps(c2, _mm_mul_ps(_mm_set1_ps(.5f), p2));
+            __m128 c3 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(.5f), _mm_sub_ps(p2, pm1)),
+                _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(p0, p1)));
+
+            value = _mm_add_ps(_mm_mul_ps(c3, res), c2);
+            value = _mm_add_ps(_mm_mul_ps(value, res), c1);
+            value = _mm_add_ps(_mm_mul_ps(value, res), p0);
+        }
+
+        _mm_storeu_ps(out + i, value);
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t saw_avx2(const float* phases, float* out, size_t n)
+{
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 two = _mm256_set1_ps(2);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 phase = _mm256_loadu_ps(phases + i);
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_mul_ps(two, phase), one));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t square_avx2(const float* phases, float* out, size_t n)
+{
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 half = _mm256_set1_ps(.5f);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 low = _mm256_cmp_ps(_mm256_loadu_ps(phases + i), half, _CMP_LT_OQ);
+        _mm256_storeu_ps(out + i, _mm256_or_ps(one, _mm256_and_ps(low, sign)));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t triangle_avx2(const float* phases, float* out, size_t n)
+{
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 three = _mm256_set1_ps(3);
+    const __m256 four = _mm256_set1_ps(4);
+    const __m256 half = _mm256_set1_ps(.5f);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 phase = _mm256_loadu_ps(phases + i);
+        __m256 scaled = _mm256_mul_ps(four, phase);
+        __m256 rising = _mm256_sub_ps(scaled, one);
+        __m256 falling = _mm256_sub_ps(three, scaled);
+        __m256 low = _mm256_cmp_ps(phase, half, _CMP_LT_OQ);
+        _mm256_storeu_ps(out + i, _mm256_blendv_ps(falling, rising, low));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t pulse_avx2(const float* phases, float* out, size_t n, float pulsewidth)
+{
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 width = _mm256_set1_ps(pulsewidth);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 high = _mm256_cmp_ps(_mm256_loadu_ps(phases + i), width, _CMP_NLT_UQ);
+        _mm256_storeu_ps(out + i, _mm256_or_ps(one, _mm256_and_ps(high, sign)));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t wavetable_avx2(const float* phases, float* out, size_t n,
+    const float* wavetable, size_t size, bool antialiasing)
+{
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 size_f = _mm256_set1_ps(size);
+    const __m256i size_i = _mm256_set1_epi32(size);
+    const __m256i last_i = _mm256_set1_epi32(size - 1);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 phase_rescaled = _mm256_mul_ps(_mm256_loadu_ps(phases + i), size_f);
+        __m256i index = _mm256_cvttps_epi32(phase_rescaled);
+        __m256 p1 = _mm256_i32gather_ps(wavetable, index, sizeof(float));
+
+        if (!antialiasing)
+        {
+            _mm256_storeu_ps(out + i, p1);
+            continue;
+        }
+
+        __m256 res = _mm256_sub_ps(phase_rescaled, _mm256_cvtepi32_ps(index));
+
+        // The following index, wrapped around the end of the table.
+        __m256i next = _mm256_cvttps_epi32(_mm256_add_ps(phase_rescaled, one));
+        __m256i wraps = _mm256_cmpgt_epi32(next, last_i);
+        next = _mm256_sub_epi32(next, _mm256_and_si256(wraps, size_i));
+        __m256 p2 = _mm256_i32gather_ps(wavetable, next, sizeof(float));
+
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(p1, _mm256_sub_ps(one, res)), _mm256_mul_ps(p2, res));
+        _mm256_storeu_ps(out + i, value);
+    }
+
+    return i;
+}
+
+template <Interpolation I>
+__attribute__((target("avx2")))
+static size_t table_avx2(const float* phases, float* out, size_t n, const float* table, size_t size)
+{
+    const __m256 size_f = _mm256_set1_ps(size);
+    const __m256i mask = _mm256_set1_epi32(size - 1);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 phase_rescaled = _mm256_mul_ps(_mm256_loadu_ps(phases + i), size_f);
+        __m256i index = _mm256_cvttps_epi32(phase_rescaled);
+        __m256 res = _mm256_sub_ps(phase_rescaled, _mm256_cvtepi32_ps(index));
+        index = _mm256_and_si256(index, mask);
+
+        __m256 p0 = _mm256_i32gather_ps(table, index, sizeof(float));
+
+        if constexpr (I == Interpolation::None)
+        {
+            _mm256_storeu_ps(out + i, p0);
+            continue;
+        }
+
+        __m256 p1 = _mm256_i32gather_ps(table + 1, index, sizeof(float));
+
+        __m256 value;
+        if constexpr (I == Interpolation::Linear)
+        {
+            value = _mm256_add_ps(p0, _mm256_mul_ps(res, _mm256_sub_ps(p1, p0)));
+        }
+        else
+        {
+            __m256 pm1 = _mm256_i32gather_ps(table - 1, index, sizeof(float));
+            __m256 p2 = _mm256_i32gather_ps(table + 2, index, sizeof(float));
+
+            __m256 c1 = _mm256_mul_ps(_mm256_set1_ps(.5f), _mm256_sub_ps(p1, pm1));
+            __m256 c2 = _mm256_sub_ps(pm1, _mm256_mul_ps(_mm256_set1_ps(2.5f), p0));
+            c2 = _mm256_add_ps(c2, _mm256_mul_ps(_mm256_set1_ps(2), p1));
+            c2 = _mm256_sub_ps(c2, _mm256_mul_ps(_mm256_set1_ps(.5f), p2));
+            __m256 c3 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(.5f), _mm256_sub_ps(p2, pm1)),
+                _mm256_mul_ps(_mm256_set1_ps(1.5f), _mm256_sub_ps(p0, p1)));
+
+            value = _mm256_add_ps(_mm256_mul_ps(c3, res), c2);
+            value = _mm256_add_ps(_mm256_mul_ps(value, res), c1);
+            value = _mm256_add_ps(_mm256_mul_ps(value, res), p0);
+        }
+
+        _mm256_storeu_ps(out + i, value);
+    }
+
+    return i;
+}
+
+template <Interpolation I>
+static size_t table_simd(const float* phases, float* out, size_t n, const float* table, size_t size)
+{
+    return has_avx2
+        ? table_avx2<I>(phases, out, n, table, size)
+        : table_sse2<I>(phases, out, n, table, size);
+}
+
+#endif // MUSICLIB_OSC_X86
+
+void osc_saw_values(const float* phases, float* out, size_t n)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    i = has_avx2 ? saw_avx2(phases, out, n) : saw_sse2(phases, out, n);
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_saw(phases[i]);
+    }
+}
+
+void osc_square_values(const float* phases, float* out, size_t n)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    i = has_avx2 ? square_avx2(phases, out, n) : square_sse2(phases, out, n);
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_square(phases[i]);
+    }
+}
+
+void osc_triangle_values(const float* phases, float* out, size_t n)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    i = has_avx2 ? triangle_avx2(phases, out, n) : triangle_sse2(phases, out, n);
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_triangle(phases[i]);
+    }
+}
+
+void osc_pulse_values(const float* phases, float* out, size_t n, float pulsewidth)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    i = has_avx2 ? pulse_avx2(phases, out, n, pulsewidth) : pulse_sse2(phases, out, n, pulsewidth);
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_pulse(phases[i], pulsewidth);
+    }
+}
+
+void osc_wavetable_values(const float* phases, float* out, size_t n,
+    const float* wavetable, size_t size, bool antialiasing)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    i = has_avx2
+        ? wavetable_avx2(phases, out, n, wavetable, size, antialiasing)
+        : wavetable_sse2(phases, out, n, wavetable, size, antialiasing);
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_wavetable(phases[i], wavetable, size, antialiasing);
+    }
+}
+
+void osc_table_values(const float* phases, float* out, size_t n,
+    const float* table, size_t size, Interpolation interpolation)
+{
+    size_t i = 0;
+
+#ifdef MUSICLIB_OSC_X86
+    switch (interpolation)
+    {
+    case Interpolation::None:
+        i = table_simd<Interpolation::None>(phases, out, n, table, size);
+        break;
+
+    case Interpolation::Linear:
+        i = table_simd<Interpolation::Linear>(phases, out, n, table, size);
+        break;
+
+    case Interpolation::Cubic:
+        i = table_simd<Interpolation::Cubic>(phases, out, n, table, size);
+        break;
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        out[i] = osc_table(phases[i], table, size, interpolation);
+    }
+}
+
+}
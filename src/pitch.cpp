@@ -1,4 +1,5 @@
 #include "pitch.hpp"
+#include "tuning.hpp"
 #include "util.hpp"
 
 #include <array>
@@ -123,9 +124,24 @@ std::optional<PitchDiatonic::Accidental> get_accidental(std::string accidental_s
     }
 }
 
-std::optional<PitchDiatonic> parse_diatonic_pitch(std::string& str)
+static_assert("C4"_pitch == 60 && "A4"_pitch == 69 && "C#4"_pitch == 61 && "Bb3"_pitch == 58);
+static_assert("Fx4"_pitch == 67 && "Ebb4"_pitch == 62 && "C-1"_pitch == 0 && "G9"_pitch == 127);
+static_assert(!midi_from_name("Cb-1") && !midi_from_name("H4") && !midi_from_name("C#") && !midi_from_name("Cbbb4"));
+
+std::optional<PitchDiatonic> parse_diatonic_pitch(std::string_view str)
+{
+    auto name = parse_pitch_name(str);
+    if (!name.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return PitchDiatonic(name->pitch_class, name->acc, name->octave);
+}
+
+std::optional<PitchDiatonic> parse_diatonic_pitch_regex(const std::string& str)
 {
-    std::regex pattern("^([A-F])(#|b{,2}|x?)(-?[0-9]+)$");
+    std::regex pattern("^([A-G])(#|b{0,2}|x?)(-?[0-9]+)$");
     std::smatch matches;
     
     if (std::regex_match(str, matches, pattern))
@@ -168,7 +184,7 @@ unsigned int PitchChromatic::midi_value() const
 
 float PitchChromatic::freq() const
 {
-    return freq_from_pitch[midi_value()];
+    return Tuning::current().freq(midi_value());
 }
 
 void PitchChromatic::transpose(int amount)
@@ -208,7 +224,7 @@ unsigned int PitchDiatonic::midi_value() const
 
 float PitchDiatonic::freq() const
 {
-    return freq_from_pitch[midi_value()];
+    return Tuning::current().freq(midi_value());
 }
 
 void PitchDiatonic::transpose(int amount)
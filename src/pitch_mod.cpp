@@ -0,0 +1,186 @@
+#include "pitch_mod.hpp"
+#include "simd.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace MusicLib {
+
+// Values computed by one SIMD instruction.
+using Simd::vfloat;
+using Simd::vint;
+
+constexpr size_t simd_width = Simd::width;
+
+/**
+ * @brief Util::exp2_fast, a register at a time, with the same operations so
+ * that the results are equal.
+ */
+static inline void exp2_fast(const vfloat& in, vfloat& out)
+{
+    const vfloat min = vfloat{} - 125;
+    const vfloat max = vfloat{} + 127;
+
+    vfloat x = in < min ? min : in;
+    x = x > max ? max : x;
+
+    vint whole = __builtin_convertvector(x, vint);
+    whole += x < __builtin_convertvector(whole, vfloat);
+    vfloat frac = x - __builtin_convertvector(whole, vfloat);
+
+    vfloat result = vfloat{} + 0.0018775762f;
+    result = result * frac + 0.0089893416f;
+    result = result * frac + 0.0558263175f;
+    result = result * frac + 0.2401536107f;
+    result = result * frac + 0.6931530833f;
+    result = result * frac + 0.9999999404f;
+
+    vint bits;
+    std::memcpy(&bits, &result, sizeof(bits));
+    bits += whole << 23;
+    std::memcpy(&out, &bits, sizeof(out));
+}
+
+PitchMod::PitchMod(float glide)
+: m_glide{glide}
+, m_bend{0}
+, m_vibrato_depth{0}
+, m_vibrato_rate{5}
+, m_pitch{0}
+, m_target{0}
+, m_glide_speed{0}
+, m_vibrato_phase{0}
+, m_has_note{false}
+{
+
+}
+
+void PitchMod::glide(float glide)
+{
+    m_glide = glide;
+}
+
+float PitchMod::glide() const
+{
+    return m_glide;
+}
+
+void PitchMod::bend(float bend)
+{
+    m_bend = bend;
+}
+
+float PitchMod::bend() const
+{
+    return m_bend;
+}
+
+void PitchMod::vibrato(float depth, float rate)
+{
+    m_vibrato_depth = depth;
+    m_vibrato_rate = rate;
+}
+
+float PitchMod::vibrato_depth() const
+{
+    return m_vibrato_depth;
+}
+
+float PitchMod::vibrato_rate() const
+{
+    return m_vibrato_rate;
+}
+
+void PitchMod::note_on(float freq)
+{
+    m_target = 12 * std::log2(freq / reference_freq);
+
+    if (m_glide > 0 && m_has_note)
+    {
+        m_glide_speed = std::abs(m_target - m_pitch) / m_glide;
+    }
+    else
+    {
+        m_pitch = m_target;
+    }
+
+    m_has_note = true;
+}
+
+void PitchMod::freq(float freq)
+{
+    m_target = 12 * std::log2(freq / reference_freq);
+    m_pitch = m_target;
+}
+
+bool PitchMod::is_active() const
+{
+    return m_pitch != m_target || m_bend != 0 || m_vibrato_depth != 0;
+}
+
+float PitchMod::process(float sample_duration)
+{
+    float phase_increment;
+    process_block(sample_duration, &phase_increment, 1);
+
+    return phase_increment;
+}
+
+void PitchMod::process_block(float sample_duration, float* phase_increments, size_t frames)
+{
+    // Rounded up to whole registers.
+    float increments[Util::block_size_max + simd_width];
+
+    const float glide_step = m_glide_speed * sample_duration;
+    const float vibrato_step = m_vibrato_rate * sample_duration;
+    const float scale = sample_duration * reference_freq;
+
+    vfloat lanes;
+    for (size_t l = 0; l < simd_width; ++l)
+    {
+        lanes[l] = l;
+    }
+
+    for (size_t offset = 0; offset < frames; offset += Util::block_size_max)
+    {
+        size_t chunk = std::min(frames - offset, Util::block_size_max);
+
+        // The distance left to the glide's target shrinks linearly.
+        float direction = m_target < m_pitch ? -1 : 1;
+        float distance = std::abs(m_target - m_pitch);
+        float base = m_target + m_bend;
+
+        for (size_t i = 0; i < chunk; i += simd_width)
+        {
+            const vfloat zero = vfloat{};
+            vfloat index = lanes + (float) i;
+
+            vfloat glide = distance - glide_step * index;
+            glide = glide > zero ? glide : zero;
+            vfloat pitch = base - direction * glide;
+
+            // A triangle LFO, starting at 0 and rising.
+            vfloat phase = m_vibrato_phase + vibrato_step * index + .25f;
+            phase -= __builtin_convertvector(__builtin_convertvector(phase, vint), vfloat);
+            vfloat lfo = phase - .5f;
+            lfo = lfo < zero ? -lfo : lfo;
+            lfo = 1 - 4 * lfo;
+
+            vfloat increment;
+            exp2_fast((pitch + m_vibrato_depth * lfo) * (1.f / 12), increment);
+            increment *= scale;
+            Simd::store(increments + i, increment);
+        }
+
+        std::copy(increments, increments + chunk, phase_increments + offset);
+
+        m_pitch = m_target - direction * std::max(distance - glide_step * chunk, 0.f);
+        m_vibrato_phase += vibrato_step * chunk;
+        m_vibrato_phase -= (int) m_vibrato_phase;
+    }
+}
+
+}
@@ -0,0 +1,295 @@
+#include "realtime_check.hpp"
+
+#ifdef MUSICLIB_REALTIME_CHECK
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace MusicLib {
+
+#ifdef MUSICLIB_REALTIME_CHECK
+
+using Violation = RealtimeCheck::Violation;
+
+constexpr size_t violation_kinds = (size_t) Violation::Count;
+
+static const char* violation_names[violation_kinds] = {
+    "allocation",
+    "deallocation",
+    "lock",
+    "sleep"
+};
+
+// Stacks are recorded into preallocated slots, since the check can't
+// allocate either.
+constexpr size_t records_max = 32;
+constexpr int record_frames_max = 32;
+
+struct Record
+{
+    Violation violation;
+    int frames;
+    void* stack[record_frames_max];
+    std::atomic<bool> is_ready;
+};
+
+static std::atomic<size_t> s_counts[violation_kinds];
+static std::atomic<size_t> s_records_used{0};
+static Record s_records[records_max];
+
+// The nesting depth of real-time scopes on this thread, and whether a
+// violation is being recorded right now (backtrace() may itself allocate).
+static thread_local int t_depth = 0;
+static thread_local bool t_is_recording = false;
+
+// backtrace() loads its unwinder on the first call, which allocates, so get
+// that done before any scope is entered.
+static const int s_is_backtrace_loaded = []
+{
+    void* frame;
+    return backtrace(&frame, 1);
+}();
+
+static void record(Violation violation)
+{
+    if (t_depth == 0 || t_is_recording)
+    {
+        return;
+    }
+
+    t_is_recording = true;
+    s_counts[(size_t) violation].fetch_add(1, std::memory_order_relaxed);
+
+    size_t index = s_records_used.fetch_add(1, std::memory_order_relaxed);
+    if (index < records_max)
+    {
+        Record& rec = s_records[index];
+        rec.violation = violation;
+        rec.frames = backtrace(rec.stack, record_frames_max);
+        rec.is_ready.store(true, std::memory_order_release);
+    }
+
+    t_is_recording = false;
+}
+
+/**
+ * @brief Find the next definition of an interposed function, i.e. the one
+ * it replaces. Resolved on first use, since it may be called before static
+ * initialization.
+ */
+template <typename F>
+static F next_function(std::atomic<F>& cache, const char* name)
+{
+    F func = cache.load(std::memory_order_relaxed);
+    if (!func)
+    {
+        func = (F) dlsym(RTLD_NEXT, name);
+        cache.store(func, std::memory_order_relaxed);
+    }
+    return func;
+}
+
+RealtimeCheck::Scope::Scope(bool is_realtime)
+: m_is_realtime{is_realtime}
+{
+    if (m_is_realtime)
+    {
+        ++t_depth;
+    }
+}
+
+RealtimeCheck::Scope::~Scope() noexcept
+{
+    if (m_is_realtime)
+    {
+        --t_depth;
+    }
+}
+
+bool RealtimeCheck::is_realtime()
+{
+    return t_depth > 0;
+}
+
+size_t RealtimeCheck::count(Violation violation)
+{
+    return s_counts[(size_t) violation].load(std::memory_order_relaxed);
+}
+
+size_t RealtimeCheck::count()
+{
+    size_t total = 0;
+    for (size_t i = 0; i < violation_kinds; ++i)
+    {
+        total += count((Violation) i);
+    }
+    return total;
+}
+
+void RealtimeCheck::report(std::ostream& os)
+{
+    os << "Real-time check: " << count() << " violations" << std::endl;
+    for (size_t i = 0; i < violation_kinds; ++i)
+    {
+        os << "    " << violation_names[i] << ": " << count((Violation) i) << std::endl;
+    }
+
+    size_t used = std::min(s_records_used.load(std::memory_order_relaxed), records_max);
+    for (size_t i = 0; i < used; ++i)
+    {
+        const Record& rec = s_records[i];
+        if (!rec.is_ready.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        os << "Violation " << i + 1 << " (" << violation_names[(size_t) rec.violation] << "):" << std::endl;
+
+        char** symbols = backtrace_symbols(rec.stack, rec.frames);
+        for (int j = 0; symbols && j < rec.frames; ++j)
+        {
+            os << "    " << symbols[j] << std::endl;
+        }
+        std::free(symbols);
+    }
+}
+
+void RealtimeCheck::reset()
+{
+    for (auto& count : s_counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& rec : s_records)
+    {
+        rec.is_ready.store(false, std::memory_order_relaxed);
+    }
+    s_records_used.store(0, std::memory_order_relaxed);
+}
+
+#else
+
+bool RealtimeCheck::is_realtime()
+{
+    return false;
+}
+
+size_t RealtimeCheck::count(Violation violation [[maybe_unused]])
+{
+    return 0;
+}
+
+size_t RealtimeCheck::count()
+{
+    return 0;
+}
+
+void RealtimeCheck::report(std::ostream& os)
+{
+    os << "Real-time check: disabled (build with MUSICLIB_REALTIME_CHECK)" << std::endl;
+}
+
+void RealtimeCheck::reset()
+{
+}
+
+#endif
+
+}
+
+#ifdef MUSICLIB_REALTIME_CHECK
+
+// Replacements of the global allocation functions. The array and nothrow
+// forms of the standard library forward to these.
+
+void* operator new(std::size_t size)
+{
+    MusicLib::record(MusicLib::Violation::Allocation);
+
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    MusicLib::record(MusicLib::Violation::Allocation);
+
+    // aligned_alloc() takes a multiple of the alignment.
+    size_t alignment = (size_t) align;
+    size = (std::max<size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+
+    if (void* ptr = std::aligned_alloc(alignment, size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr)
+    {
+        MusicLib::record(MusicLib::Violation::Deallocation);
+    }
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t align [[maybe_unused]]) noexcept
+{
+    if (ptr)
+    {
+        MusicLib::record(MusicLib::Violation::Deallocation);
+    }
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size [[maybe_unused]]) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size [[maybe_unused]], std::align_val_t align) noexcept
+{
+    ::operator delete(ptr, align);
+}
+
+// Interposed blocking calls. std::mutex locks through pthread_mutex_lock(),
+// and std::this_thread::sleep_for() sleeps through nanosleep().
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    static std::atomic<int (*)(pthread_mutex_t*)> next{nullptr};
+
+    MusicLib::record(MusicLib::Violation::Lock);
+    return MusicLib::next_function(next, "pthread_mutex_lock")(mutex);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    static std::atomic<int (*)(const struct timespec*, struct timespec*)> next{nullptr};
+
+    MusicLib::record(MusicLib::Violation::Sleep);
+    return MusicLib::next_function(next, "nanosleep")(duration, remaining);
+}
+
+extern "C" int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration,
+    struct timespec* remaining)
+{
+    static std::atomic<int (*)(clockid_t, int, const struct timespec*, struct timespec*)> next{nullptr};
+
+    MusicLib::record(MusicLib::Violation::Sleep);
+    return MusicLib::next_function(next, "clock_nanosleep")(clock, flags, duration, remaining);
+}
+
+#endif
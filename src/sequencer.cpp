@@ -3,7 +3,9 @@
 #include "command_stream.hpp"
 
 #include <portaudio.h>
+#include <algorithm>
 #include <functional>
+#include <limits>
 
 namespace MusicLib {
 
@@ -21,6 +23,26 @@ void MultiSequencer::tick()
     }
 }
 
+void MultiSequencer::advance(unsigned long samples)
+{
+    for (auto& seq : m_seqs)
+    {
+        seq.advance(samples);
+    }
+}
+
+unsigned long MultiSequencer::samples_until_step() const
+{
+    unsigned long samples = std::numeric_limits<unsigned long>::max();
+
+    for (const auto& seq : m_seqs)
+    {
+        samples = std::min(samples, seq.samples_until_step());
+    }
+
+    return samples;
+}
+
 void MultiSequencer::step()
 {
     for (auto& seq : m_seqs)
@@ -29,6 +51,35 @@ void MultiSequencer::step()
     }
 }
 
+void MultiSequencer::execute(Command& cmd)
+{
+    for (auto& seq : m_seqs)
+    {
+        seq.execute(cmd);
+    }
+}
+
+void MultiSequencer::playing(bool playing)
+{
+    for (auto& seq : m_seqs)
+    {
+        seq.playing(playing);
+    }
+}
+
+bool MultiSequencer::playing() const
+{
+    for (const auto& seq : m_seqs)
+    {
+        if (seq.playing())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void MultiSequencer::reset()
 {
     for (auto& seq : m_seqs)
@@ -55,6 +106,24 @@ void SequencerBasic::tick()
     }
 }
 
+void SequencerBasic::advance(unsigned long samples)
+{
+    if (m_time_mgr.playing() && m_time_mgr.count_samples(samples))
+    {
+        step();
+    }
+}
+
+unsigned long SequencerBasic::samples_until_step() const
+{
+    if (!m_time_mgr.playing())
+    {
+        return std::numeric_limits<unsigned long>::max();
+    }
+
+    return m_time_mgr.samples_until_step();
+}
+
 void SequencerBasic::step()
 {
     auto cmd = m_cmd_stream.current();
@@ -66,9 +135,7 @@ void SequencerBasic::step()
     }
 
     // Handle the command.
-    m_cmd_processor.handle_command_stream(*cmd, m_cmd_stream);
-    m_cmd_processor.handle_time_manager(*cmd, m_time_mgr);
-    m_cmd_processor.handle_device(*cmd, m_device);
+    m_cmd_processor.handle(*cmd, m_cmd_stream, m_time_mgr, m_device);
 
     // Go to next command.
     m_cmd_stream.step();
@@ -79,6 +146,22 @@ void SequencerBasic::step()
     }
 }
 
+void SequencerBasic::execute(Command& cmd)
+{
+    m_cmd_processor.handle_time_manager(cmd, m_time_mgr);
+    m_cmd_processor.handle_device(cmd, m_device);
+}
+
+void SequencerBasic::playing(bool playing)
+{
+    m_time_mgr.playing(playing);
+}
+
+bool SequencerBasic::playing() const
+{
+    return m_time_mgr.playing();
+}
+
 void SequencerBasic::reset()
 {
     m_cmd_stream.reset();
@@ -95,12 +178,30 @@ SequencerMultiChannel::SequencerMultiChannel(TimeManager& time_mgr, IDevice& dev
 
 void SequencerMultiChannel::tick()
 {
-    if (m_time_mgr.count_sample() == 0)
+    if (m_time_mgr.playing() && m_time_mgr.count_sample())
     {
         step();
     }
 }
 
+void SequencerMultiChannel::advance(unsigned long samples)
+{
+    if (m_time_mgr.playing() && m_time_mgr.count_samples(samples))
+    {
+        step();
+    }
+}
+
+unsigned long SequencerMultiChannel::samples_until_step() const
+{
+    if (!m_time_mgr.playing())
+    {
+        return std::numeric_limits<unsigned long>::max();
+    }
+
+    return m_time_mgr.samples_until_step();
+}
+
 void SequencerMultiChannel::step()
 {
     for (auto& cs : m_cmd_streams)
@@ -108,15 +209,29 @@ void SequencerMultiChannel::step()
         auto cmd = cs.current();
         
         // Handle the command.
-        m_cmd_processor.handle_command_stream(*cmd, cs);
-        m_cmd_processor.handle_device(*cmd, m_device);
-        m_cmd_processor.handle_time_manager(*cmd, m_time_mgr);
+        m_cmd_processor.handle(*cmd, cs, m_time_mgr, m_device);
         
         // Go to next command.
         cs.step();
     }
 }
 
+void SequencerMultiChannel::execute(Command& cmd)
+{
+    m_cmd_processor.handle_time_manager(cmd, m_time_mgr);
+    m_cmd_processor.handle_device(cmd, m_device);
+}
+
+void SequencerMultiChannel::playing(bool playing)
+{
+    m_time_mgr.playing(playing);
+}
+
+bool SequencerMultiChannel::playing() const
+{
+    return m_time_mgr.playing();
+}
+
 void SequencerMultiChannel::reset()
 {
     for (auto& cs : m_cmd_streams)
@@ -0,0 +1,67 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace MusicLib {
+
+/**
+ * @brief Portable SIMD registers, using the GCC vector extensions, for the
+ * kernels that process several voices or samples at once.
+ */
+namespace Simd {
+
+/**
+ * @brief Lanes in the widest register of the instruction set the library is
+ * compiled for. Kernels dispatched at runtime use wider registers when the
+ * CPU has them.
+ */
+#if defined(__AVX512F__)
+constexpr size_t width = 16;
+#elif defined(__AVX__)
+constexpr size_t width = 8;
+#else
+constexpr size_t width = 4;
+#endif
+
+/**
+ * @brief Registers of W floats or ints, one per lane. The attribute is
+ * dropped from alias templates, so the types are declared in a class.
+ */
+template <size_t W>
+struct Vector
+{
+    typedef float vfloat __attribute__((vector_size(W * sizeof(float))));
+    typedef int32_t vint __attribute__((vector_size(W * sizeof(int32_t))));
+};
+
+template <size_t W>
+using vfloat_n = typename Vector<W>::vfloat;
+
+template <size_t W>
+using vint_n = typename Vector<W>::vint;
+
+using vfloat = vfloat_n<width>;
+using vint = vint_n<width>;
+
+// Vectors are passed by reference, since passing them by value depends on
+// the instruction set the caller was compiled for.
+template <typename V, typename T>
+inline void load(V& dst, const T* src)
+{
+    std::memcpy(&dst, src, sizeof(V));
+}
+
+template <typename V, typename T>
+inline void store(T* dst, const V& src)
+{
+    std::memcpy(dst, &src, sizeof(V));
+}
+
+}
+
+}
+
+#endif // SIMD_H_
@@ -0,0 +1,118 @@
+#include "song_file.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace MusicLib {
+
+static_assert(std::endian::native == std::endian::little, "compiled songs are little-endian");
+
+static constexpr char song_magic[8] = {'M', 'U', 'S', 'I', 'C', 'L', 'I', 'B'};
+
+// Events start on a cache line, which also satisfies the alignment of any
+// reasonable event type.
+static constexpr uint64_t events_alignment = 64;
+
+static uint64_t align_up(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Whether an array of count elements of the given size starting at
+ * offset lies within a file of the given size, without overflowing.
+ */
+static bool is_in_file(uint64_t offset, uint64_t size, uint64_t count, uint64_t file_size)
+{
+    return offset <= file_size && (size == 0 || count <= (file_size - offset) / size);
+}
+
+SongFile::SongFile(const std::string& filename)
+: m_file{filename}
+{
+    const SongHeader* h = header();
+    size_t size = m_file.size();
+
+    const char* error = nullptr;
+    if (size < sizeof(SongHeader) || std::memcmp(h->magic, song_magic, sizeof(song_magic)) != 0)
+    {
+        error = "not a compiled song: ";
+    }
+    else if (h->version != version)
+    {
+        error = "unsupported compiled song version: ";
+    }
+    else if (h->instrument_size != sizeof(SongInstrument)
+        || h->instruments_offset % alignof(SongInstrument) != 0
+        || !is_in_file(h->instruments_offset, sizeof(SongInstrument), h->instrument_count, size)
+        || !is_in_file(h->events_offset, h->event_size, h->event_count, size))
+    {
+        error = "corrupt compiled song: ";
+    }
+
+    if (error)
+    {
+        throw std::runtime_error(error + filename);
+    }
+}
+
+bool SongFile::is_song_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(song_magic)];
+
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, song_magic, sizeof(magic)) == 0;
+}
+
+void SongFile::write(const std::string& filename, uint32_t format,
+    std::span<const SongInstrument> instruments, const void* events, size_t event_size, size_t event_count)
+{
+    SongHeader header{};
+    std::memcpy(header.magic, song_magic, sizeof(song_magic));
+    header.version = version;
+    header.format = format;
+    header.instrument_size = sizeof(SongInstrument);
+    header.instrument_count = instruments.size();
+    header.event_size = event_size;
+    header.event_count = event_count;
+    header.instruments_offset = align_up(sizeof(SongHeader), alignof(SongInstrument));
+    header.events_offset = align_up(header.instruments_offset + instruments.size_bytes(), events_alignment);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("cannot open output file " + filename);
+    }
+
+    const char padding[events_alignment] = {};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, header.instruments_offset - sizeof(header));
+    file.write(reinterpret_cast<const char*>(instruments.data()), instruments.size_bytes());
+    file.write(padding, header.events_offset - header.instruments_offset - instruments.size_bytes());
+    file.write(static_cast<const char*>(events), event_size * event_count);
+
+    if (!file)
+    {
+        throw std::runtime_error("cannot write compiled song " + filename);
+    }
+}
+
+uint32_t SongFile::format() const
+{
+    return header()->format;
+}
+
+std::span<const SongInstrument> SongFile::instruments() const
+{
+    return {reinterpret_cast<const SongInstrument*>(m_file.data() + header()->instruments_offset),
+        (size_t) header()->instrument_count};
+}
+
+const SongHeader* SongFile::header() const
+{
+    return reinterpret_cast<const SongHeader*>(m_file.data());
+}
+
+}
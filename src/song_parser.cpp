@@ -0,0 +1,223 @@
+#include "song_parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace MusicLib {
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+SongParser::SongParser()
+: m_chunk{}
+, m_finished{false}
+, m_lines{0}
+, m_carry{}
+, m_carry_size{0}
+, m_carry_overflow{false}
+, m_carry_read{false}
+, m_errors{}
+, m_error_count{0}
+{}
+
+SongParser::SongParser(std::string_view text)
+: SongParser{}
+{
+    feed(text);
+    finish();
+}
+
+void SongParser::feed(std::string_view chunk)
+{
+    m_chunk = chunk;
+}
+
+void SongParser::finish()
+{
+    m_finished = true;
+}
+
+bool SongParser::next(SongLine& line)
+{
+    std::string_view text;
+
+    while (next_text(text))
+    {
+        const char* p = text.data();
+        const char* end = p + text.size();
+        size_t count = 0;
+        bool is_overflow = false;
+
+        while (true)
+        {
+            while (p != end && is_space(*p))
+            {
+                ++p;
+            }
+
+            if (p == end)
+            {
+                break;
+            }
+
+            const char* start = p;
+            while (p != end && !is_space(*p))
+            {
+                ++p;
+            }
+
+            if (count == SongLine::tokens_max)
+            {
+                is_overflow = true;
+                break;
+            }
+
+            line.m_tokens[count++] = {start, (size_t) (p - start)};
+        }
+
+        if (is_overflow)
+        {
+            error(m_lines, "too many tokens");
+            continue;
+        }
+
+        if (count > 0)
+        {
+            line.m_size = count;
+            line.m_number = m_lines;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SongParser::error(const SongLine& line, const char* message)
+{
+    error(line.number(), message);
+}
+
+size_t SongParser::lines() const
+{
+    return m_lines;
+}
+
+size_t SongParser::error_count() const
+{
+    return m_error_count;
+}
+
+std::span<const SongParseError> SongParser::errors() const
+{
+    return {m_errors.data(), std::min(m_error_count, errors_max)};
+}
+
+size_t SongParser::count_lines(std::string_view text)
+{
+    size_t count = std::count(text.begin(), text.end(), '\n');
+
+    if (!text.empty() && text.back() != '\n')
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Get the text of the next line, blank or not. Lines are read in
+ * place, except for those that span chunks, which are read from the carry
+ * buffer.
+ */
+bool SongParser::next_text(std::string_view& text)
+{
+    // The last line came from the carry buffer, which is free again.
+    if (m_carry_read)
+    {
+        m_carry_size = 0;
+        m_carry_overflow = false;
+        m_carry_read = false;
+    }
+
+    if (!m_chunk.empty())
+    {
+        size_t end = m_chunk.find('\n');
+
+        if (end != std::string_view::npos)
+        {
+            std::string_view piece = m_chunk.substr(0, end);
+            m_chunk.remove_prefix(end + 1);
+            ++m_lines;
+
+            if (m_carry_size == 0 && !m_carry_overflow)
+            {
+                text = piece;
+                return true;
+            }
+
+            carry(piece);
+        }
+        else
+        {
+            // The line continues in the next chunk.
+            carry(m_chunk);
+            m_chunk = {};
+
+            if (!m_finished)
+            {
+                return false;
+            }
+
+            ++m_lines;
+        }
+    }
+    else if (m_finished && (m_carry_size > 0 || m_carry_overflow))
+    {
+        ++m_lines;
+    }
+    else
+    {
+        return false;
+    }
+
+    m_carry_read = true;
+
+    if (m_carry_overflow)
+    {
+        // Read as a blank line.
+        error(m_lines, "line too long");
+        text = {};
+    }
+    else
+    {
+        text = {m_carry.data(), m_carry_size};
+    }
+
+    return true;
+}
+
+void SongParser::carry(std::string_view text)
+{
+    if (text.size() > line_length_max - m_carry_size)
+    {
+        m_carry_overflow = true;
+        return;
+    }
+
+    std::memcpy(m_carry.data() + m_carry_size, text.data(), text.size());
+    m_carry_size += text.size();
+}
+
+void SongParser::error(size_t line, const char* message)
+{
+    if (m_error_count < errors_max)
+    {
+        m_errors[m_error_count] = {line, message};
+    }
+
+    ++m_error_count;
+}
+
+}
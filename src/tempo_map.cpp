@@ -0,0 +1,167 @@
+#include "tempo_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace MusicLib {
+
+TempoMap::TempoMap(unsigned long sample_rate, float bpm, unsigned int steps_per_beat, float shuffle)
+: m_sample_rate{sample_rate}
+, m_steps_per_beat{1}
+, m_segments{}
+{
+    this->steps_per_beat(steps_per_beat);
+    change(0, bpm, shuffle);
+}
+
+void TempoMap::change(unsigned long step, float bpm, float shuffle)
+{
+    validate(bpm, shuffle);
+
+    Segment segment{step, 0, 0, m_sample_rate * 60.0 / ((double) bpm * m_steps_per_beat), bpm, shuffle};
+
+    auto it = std::lower_bound(m_segments.begin(), m_segments.end(), step,
+        [](const Segment& s, unsigned long step) { return s.step < step; });
+
+    if (it != m_segments.end() && it->step == step)
+    {
+        *it = segment;
+    }
+    else
+    {
+        it = m_segments.insert(it, segment);
+    }
+
+    compile(it - m_segments.begin());
+}
+
+void TempoMap::steps_per_beat(unsigned int steps_per_beat)
+{
+    if (steps_per_beat == 0)
+    {
+        throw std::runtime_error("steps per beat must be positive");
+    }
+
+    m_steps_per_beat = steps_per_beat;
+}
+
+unsigned int TempoMap::steps_per_beat() const
+{
+    return m_steps_per_beat;
+}
+
+void TempoMap::reserve(size_t changes)
+{
+    m_segments.reserve(changes);
+}
+
+size_t TempoMap::changes() const
+{
+    return m_segments.size();
+}
+
+unsigned long TempoMap::sample_rate() const
+{
+    return m_sample_rate;
+}
+
+float TempoMap::bpm(unsigned long step) const
+{
+    return segment_of_step(step).bpm;
+}
+
+float TempoMap::shuffle(unsigned long step) const
+{
+    return segment_of_step(step).shuffle;
+}
+
+double TempoMap::step_duration(unsigned long step) const
+{
+    return segment_of_step(step).samples_per_step / m_sample_rate;
+}
+
+unsigned long TempoMap::sample_of_step(unsigned long step) const
+{
+    const Segment& segment = segment_of_step(step);
+
+    return segment.sample + (unsigned long) offset(segment, step);
+}
+
+unsigned long TempoMap::step_at_sample(unsigned long sample) const
+{
+    // The last segment whose first step starts at or before the sample. The
+    // first segment always starts at sample 0.
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), sample,
+        [](unsigned long sample, const Segment& s) { return sample < s.sample; });
+    const Segment& segment = *(it - 1);
+
+    // A step starts at or before the sample if its offset is below the end
+    // of the sample.
+    double end = (double) (sample - segment.sample) + 1;
+
+    // Shuffle moves a step by less than a step, so the estimate is off by at
+    // most one.
+    unsigned long step = segment.step + (unsigned long) ((end - segment.carry) / segment.samples_per_step);
+
+    while (step > segment.step && offset(segment, step) >= end)
+    {
+        --step;
+    }
+
+    while (offset(segment, step + 1) < end)
+    {
+        ++step;
+    }
+
+    return step;
+}
+
+const TempoMap::Segment& TempoMap::segment_of_step(unsigned long step) const
+{
+    // The first segment always starts at step 0.
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), step,
+        [](unsigned long step, const Segment& s) { return step < s.step; });
+
+    return *(it - 1);
+}
+
+void TempoMap::validate(float bpm, float shuffle)
+{
+    if (!(bpm > 0))
+    {
+        throw std::runtime_error("tempo must be positive");
+    }
+
+    if (!(shuffle > 0 && shuffle < 1))
+    {
+        throw std::runtime_error("shuffle must be between 0 and 1");
+    }
+}
+
+double TempoMap::offset(const Segment& segment, unsigned long step)
+{
+    unsigned long steps = step - segment.step;
+    unsigned long evens = (step + 1) / 2 - (segment.step + 1) / 2;
+    unsigned long odds = steps - evens;
+
+    return segment.carry + 2 * segment.samples_per_step
+        * (segment.shuffle * (double) evens + (1 - (double) segment.shuffle) * odds);
+}
+
+void TempoMap::compile(size_t first)
+{
+    for (size_t i = std::max<size_t>(first, 1); i < m_segments.size(); ++i)
+    {
+        const Segment& previous = m_segments[i - 1];
+        Segment& segment = m_segments[i];
+
+        double position = offset(previous, segment.step);
+        double whole = std::floor(position);
+
+        segment.sample = previous.sample + (unsigned long) whole;
+        segment.carry = position - whole;
+    }
+}
+
+}
@@ -29,27 +29,37 @@ bool TimeManagerEventBased::count_sample()
     return m_sample_counter == 0;
 }
 
+bool TimeManagerEventBased::count_samples(unsigned long samples)
+{
+    m_sample_counter = m_sample_counter > samples ? m_sample_counter - samples : 0;
+
+    return m_sample_counter == 0;
+}
+
+unsigned long TimeManagerEventBased::samples_until_step() const
+{
+    return m_sample_counter > 0 ? m_sample_counter : 1;
+}
+
 void TimeManagerEventBased::reset_counter(unsigned long samples_until_next_step)
 {
     m_sample_counter = samples_until_next_step;
 }
 
 TimeManagerTempo::TimeManagerTempo(unsigned long sample_rate, float bpm, unsigned int steps_per_beat, float shuffle)
-: m_playing{false}
-, m_bpm{bpm}
-, m_steps_per_beat{steps_per_beat}
-, m_step_duration{60.0f / (bpm * steps_per_beat)}
-, m_sample_rate{sample_rate}
-, m_samples_per_step{(unsigned long) (sample_rate * m_step_duration)}
-, m_sample_counter{m_samples_per_step}
-, m_shuffle{shuffle}
+: TimeManagerTempo{TempoMap{sample_rate, bpm, steps_per_beat, shuffle}}
 {
-    long sps = (unsigned long) (sample_rate * m_step_duration);
 
-    if (sps >= 0)
-    {
-        m_samples_per_step = sps;
-    }
+}
+
+TimeManagerTempo::TimeManagerTempo(const TempoMap& tempo_map)
+: m_playing{false}
+, m_tempo_map{tempo_map}
+, m_sample{0}
+, m_next_step{1}
+, m_next_sample{tempo_map.sample_of_step(1)}
+{
+    m_tempo_map.reserve(m_tempo_map.changes() + live_changes_max);
 }
 
 void TimeManagerTempo::playing(bool playing)
@@ -64,40 +74,100 @@ bool TimeManagerTempo::playing() const
 
 bool TimeManagerTempo::count_sample()
 {
-    if (m_sample_counter > 0)
-    {
-        --m_sample_counter;
-    }
+    return count_samples(1);
+}
 
-    if (m_sample_counter == 0)
+bool TimeManagerTempo::count_samples(unsigned long samples)
+{
+    m_sample += samples;
+
+    if (m_sample < m_next_sample)
     {
-        m_sample_counter = m_samples_per_step;
-        return true;
+        return false;
     }
 
-    return false;
+    ++m_next_step;
+    m_next_sample = m_tempo_map.sample_of_step(m_next_step);
+
+    return true;
 }
 
-float TimeManagerTempo::step_duration()
+unsigned long TimeManagerTempo::samples_until_step() const
 {
-    return 60.0 / m_bpm;
+    return m_next_sample > m_sample ? m_next_sample - m_sample : 1;
 }
 
 float TimeManagerTempo::bpm() const
 {
-    return m_bpm;
+    return m_tempo_map.bpm(step());
 }
 
 void TimeManagerTempo::bpm(float bpm)
 {
-    if (bpm < 0)
+    if (!(bpm > 0))
     {
         return;
     }
-    
-    m_bpm = bpm;
-    m_step_duration = 60.0f / (bpm * m_steps_per_beat);
-    m_samples_per_step = (unsigned long) (m_step_duration * m_sample_rate);
+
+    live_change(bpm, m_tempo_map.shuffle(m_next_step));
+}
+
+float TimeManagerTempo::shuffle() const
+{
+    return m_tempo_map.shuffle(step());
 }
 
-}
\ No newline at end of file
+void TimeManagerTempo::shuffle(float shuffle)
+{
+    if (!(shuffle > 0 && shuffle < 1))
+    {
+        return;
+    }
+
+    live_change(m_tempo_map.bpm(m_next_step), shuffle);
+}
+
+void TimeManagerTempo::steps_per_beat(unsigned int steps_per_beat)
+{
+    if (steps_per_beat == 0)
+    {
+        return;
+    }
+
+    m_tempo_map.steps_per_beat(steps_per_beat);
+    live_change(m_tempo_map.bpm(m_next_step), m_tempo_map.shuffle(m_next_step));
+}
+
+float TimeManagerTempo::step_duration() const
+{
+    return m_tempo_map.step_duration(step());
+}
+
+unsigned long TimeManagerTempo::sample() const
+{
+    return m_sample;
+}
+
+unsigned long TimeManagerTempo::step() const
+{
+    return m_next_step - 1;
+}
+
+void TimeManagerTempo::seek(unsigned long sample)
+{
+    m_sample = sample;
+    m_next_step = m_tempo_map.step_at_sample(sample) + 1;
+    m_next_sample = m_tempo_map.sample_of_step(m_next_step);
+}
+
+const TempoMap& TimeManagerTempo::tempo_map() const
+{
+    return m_tempo_map;
+}
+
+void TimeManagerTempo::live_change(float bpm, float shuffle)
+{
+    m_tempo_map.change(m_next_step, bpm, shuffle);
+}
+
+}
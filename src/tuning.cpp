@@ -0,0 +1,21 @@
+#include "tuning.hpp"
+
+#include <atomic>
+
+namespace MusicLib {
+
+static constinit std::atomic<const Tuning*> current_tuning{&tuning_standard};
+
+static_assert(std::atomic<const Tuning*>::is_always_lock_free, "tuning swaps must be lock-free");
+
+const Tuning& Tuning::current()
+{
+    return *current_tuning.load(std::memory_order_acquire);
+}
+
+const Tuning& Tuning::use(const Tuning& tuning)
+{
+    return *current_tuning.exchange(&tuning, std::memory_order_acq_rel);
+}
+
+}
@@ -0,0 +1,551 @@
+#include "voice_bank.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MUSICLIB_VOICE_BANK_X86
+#include <immintrin.h>
+#endif
+
+namespace MusicLib {
+
+using Simd::vfloat_n;
+using Simd::vint_n;
+using Simd::load;
+using Simd::store;
+
+#ifdef MUSICLIB_VOICE_BANK_X86
+
+// The kernel is compiled for the widest register the target has, and
+// cloned for AVX2 (8 voices at a time). The AVX-512 kernel (16 voices at a
+// time) is written with intrinsics, since GCC only compiles comparisons of
+// 16 lanes into mask registers in functions parsed for AVX-512. The wider
+// kernels are called if the CPU running the library supports them.
+
+static bool cpu_has_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool cpu_has_avx512()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+static const bool has_avx2 = cpu_has_avx2();
+static const bool has_avx512 = cpu_has_avx512();
+
+#endif // MUSICLIB_VOICE_BANK_X86
+
+// Frames rendered per pass over the voices. The partial sums of a pass take
+// 16 kB.
+constexpr size_t chunk_frames = 256;
+
+template <size_t W, VoiceBank::Shape S>
+__attribute__((always_inline))
+static inline void shape_value(const vfloat_n<W>& phase, const vfloat_n<W>& pulsewidth [[maybe_unused]], vfloat_n<W>& out)
+{
+    const vfloat_n<W> one = vfloat_n<W>{} + 1;
+
+    // Branchless versions of the functions in osc.cpp.
+    if constexpr (S == VoiceBank::Shape::Saw)
+    {
+        out = 2 * phase - 1;
+    }
+    else if constexpr (S == VoiceBank::Shape::Square)
+    {
+        out = phase < .5f ? -one : one;
+    }
+    else if constexpr (S == VoiceBank::Shape::Triangle)
+    {
+        out = phase < .5f ? 4 * phase - 1 : 3 - 4 * phase;
+    }
+    else
+    {
+        out = phase < pulsewidth ? one : -one;
+    }
+}
+
+/**
+ * @brief Sum the lanes of a register pairwise, adding the upper half to the
+ * lower half until one lane is left.
+ */
+template <size_t W>
+__attribute__((always_inline))
+static inline float sum_lanes(const vfloat_n<W>& v)
+{
+    if constexpr (W == 1)
+    {
+        return v[0];
+    }
+    else
+    {
+        vfloat_n<W / 2> low, high;
+        load(low, reinterpret_cast<const float*>(&v));
+        load(high, reinterpret_cast<const float*>(&v) + W / 2);
+        low += high;
+
+        return sum_lanes<W / 2>(low);
+    }
+}
+
+/**
+ * @brief The rendering kernels of VoiceBank, one per register width. They
+ * all sum the voices in the same order, so the output doesn't depend on the
+ * CPU.
+ */
+class VoiceBankKernels
+{
+public:
+    template <VoiceBank::Shape S>
+    static void render_default(VoiceBank& bank, float sample_duration, float* output, size_t frames)
+    {
+        render<Simd::width, S>(bank, sample_duration, output, frames);
+    }
+
+#ifdef MUSICLIB_VOICE_BANK_X86
+    template <VoiceBank::Shape S>
+    __attribute__((target("avx2")))
+    static void render_avx2(VoiceBank& bank, float sample_duration, float* output, size_t frames)
+    {
+        render<8, S>(bank, sample_duration, output, frames);
+    }
+
+    /**
+     * @brief The kernel of render(), 16 voices at a time, following it
+     * operation by operation.
+     */
+    template <VoiceBank::Shape S>
+    __attribute__((target("avx512f")))
+    static void render_avx512(VoiceBank& bank, float sample_duration, float* output, size_t frames)
+    {
+        using Stage = VoiceBank::Stage;
+
+        constexpr size_t lanes = VoiceBank::lanes;
+        static_assert(lanes == 16, "a register must hold a cache line of voices");
+
+        alignas(Util::cache_line_size) float sums[chunk_frames * lanes];
+
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 one = _mm512_set1_ps(1);
+        const __m512 half = _mm512_set1_ps(.5f);
+        const __m512 duration = _mm512_set1_ps(sample_duration);
+        const __m512 pulsewidth = _mm512_set1_ps(bank.m_pulsewidth);
+        const __m512i sign = _mm512_set1_epi32(INT32_MIN);
+
+        const __m512i off = _mm512_set1_epi32(Stage::OFF);
+        const __m512i attack = _mm512_set1_epi32(Stage::ATTACK);
+        const __m512i decay = _mm512_set1_epi32(Stage::DECAY);
+        const __m512i sustain_stage = _mm512_set1_epi32(Stage::SUSTAIN);
+        const __m512i release = _mm512_set1_epi32(Stage::RELEASE);
+
+        for (size_t offset = 0; offset < frames; offset += chunk_frames)
+        {
+            size_t chunk = std::min(frames - offset, chunk_frames);
+            std::fill(sums, sums + chunk * lanes, 0.0f);
+
+            for (size_t group = 0; group < bank.m_phase.size(); group += lanes)
+            {
+                __m512i stage = _mm512_load_si512(&bank.m_stage[group]);
+
+                if (_mm512_cmpneq_epi32_mask(stage, off) == 0)
+                {
+                    continue;
+                }
+
+                __m512 phase = _mm512_load_ps(&bank.m_phase[group]);
+                __m512 vol = _mm512_load_ps(&bank.m_vol[group]);
+                __m512 level = _mm512_load_ps(&bank.m_level[group]);
+                __m512 sustain = _mm512_load_ps(&bank.m_sustain[group]);
+
+                __m512 phase_inc = _mm512_mul_ps(duration, _mm512_load_ps(&bank.m_freq[group]));
+                __m512 attack_inc = _mm512_div_ps(duration, _mm512_load_ps(&bank.m_attack[group]));
+                __m512 decay_inc = _mm512_div_ps(duration, _mm512_load_ps(&bank.m_decay[group]));
+                __m512 release_inc = _mm512_div_ps(duration, _mm512_load_ps(&bank.m_release[group]));
+
+                // Negated by flipping the sign bit, like the unary minus.
+                __m512 decay_dec = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(decay_inc), sign));
+                __m512 release_dec = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(release_inc), sign));
+
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    __mmask16 is_attack = _mm512_cmpeq_epi32_mask(stage, attack);
+                    __mmask16 is_decay = _mm512_cmpeq_epi32_mask(stage, decay);
+                    __mmask16 is_release = _mm512_cmpeq_epi32_mask(stage, release);
+
+                    __m512 delta = _mm512_mask_blend_ps(is_attack, zero, attack_inc);
+                    delta = _mm512_mask_blend_ps(is_decay, delta, decay_dec);
+                    delta = _mm512_mask_blend_ps(is_release, delta, release_dec);
+                    level = _mm512_add_ps(level, delta);
+
+                    __mmask16 attack_done = is_attack & _mm512_cmp_ps_mask(level, one, _CMP_GE_OQ);
+                    __mmask16 decay_done = is_decay & _mm512_cmp_ps_mask(level, sustain, _CMP_LE_OQ);
+                    __mmask16 release_done = is_release & _mm512_cmp_ps_mask(level, zero, _CMP_LE_OQ);
+                    __mmask16 is_off = _mm512_cmpeq_epi32_mask(stage, off);
+
+                    level = _mm512_mask_blend_ps(attack_done, level, one);
+                    level = _mm512_mask_blend_ps(decay_done, level, sustain);
+                    level = _mm512_mask_blend_ps(release_done | is_off, level, zero);
+
+                    stage = _mm512_mask_blend_epi32(attack_done, stage, decay);
+                    stage = _mm512_mask_blend_epi32(decay_done, stage, sustain_stage);
+                    stage = _mm512_mask_blend_epi32(release_done, stage, off);
+
+                    __m512 out;
+                    if constexpr (S == VoiceBank::Shape::Saw)
+                    {
+                        out = _mm512_sub_ps(_mm512_mul_ps(_mm512_set1_ps(2), phase), one);
+                    }
+                    else if constexpr (S == VoiceBank::Shape::Square)
+                    {
+                        __mmask16 low = _mm512_cmp_ps_mask(phase, half, _CMP_LT_OQ);
+                        out = _mm512_mask_blend_ps(low, one, _mm512_set1_ps(-1));
+                    }
+                    else if constexpr (S == VoiceBank::Shape::Triangle)
+                    {
+                        __m512 scaled = _mm512_mul_ps(_mm512_set1_ps(4), phase);
+                        __mmask16 low = _mm512_cmp_ps_mask(phase, half, _CMP_LT_OQ);
+                        out = _mm512_mask_blend_ps(low, _mm512_sub_ps(_mm512_set1_ps(3), scaled), _mm512_sub_ps(scaled, one));
+                    }
+                    else
+                    {
+                        __mmask16 high = _mm512_cmp_ps_mask(phase, pulsewidth, _CMP_LT_OQ);
+                        out = _mm512_mask_blend_ps(high, _mm512_set1_ps(-1), one);
+                    }
+                    out = _mm512_mul_ps(_mm512_mul_ps(vol, out), level);
+
+                    // Propagate phase.
+                    phase = _mm512_add_ps(phase, phase_inc);
+                    phase = _mm512_mask_sub_ps(phase, _mm512_cmp_ps_mask(phase, one, _CMP_GE_OQ), phase, one);
+
+                    // Added with explicit rounding, which GCC doesn't fuse
+                    // with the product into a multiply-add, so the sums are
+                    // rounded like the other kernels'.
+                    float* frame_sums = sums + i * lanes;
+                    __m512 sum = _mm512_load_ps(frame_sums);
+                    sum = _mm512_add_round_ps(sum, out, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                    _mm512_store_ps(frame_sums, sum);
+                }
+
+                _mm512_store_ps(&bank.m_phase[group], phase);
+                _mm512_store_ps(&bank.m_level[group], level);
+                _mm512_store_si512(&bank.m_stage[group], stage);
+            }
+
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                vfloat_n<lanes> frame_sums;
+                load(frame_sums, sums + i * lanes);
+                output[offset + i] = sum_lanes<lanes>(frame_sums);
+            }
+        }
+    }
+#endif
+
+private:
+    /**
+     * @brief Render a block of all voices, W voices at a time.
+     */
+    template <size_t W, VoiceBank::Shape S>
+    __attribute__((always_inline))
+    static inline void render(VoiceBank& bank, float sample_duration, float* output, size_t frames)
+    {
+        using vfloat = vfloat_n<W>;
+        using vint = vint_n<W>;
+        using Stage = VoiceBank::Stage;
+
+        constexpr size_t lanes = VoiceBank::lanes;
+
+        // Voice v is added to partial sum v % lanes of each frame, whatever
+        // the register width, and the partial sums are added once per frame
+        // at the end of the chunk.
+        alignas(Util::cache_line_size) float sums[chunk_frames * lanes];
+
+        const vfloat zero = vfloat{};
+        const vfloat one = zero + 1;
+        const vfloat pulsewidth = zero + bank.m_pulsewidth;
+
+        const vint off = vint{} + (int32_t) Stage::OFF;
+        const vint attack = vint{} + (int32_t) Stage::ATTACK;
+        const vint decay = vint{} + (int32_t) Stage::DECAY;
+        const vint sustain_stage = vint{} + (int32_t) Stage::SUSTAIN;
+        const vint release = vint{} + (int32_t) Stage::RELEASE;
+
+        for (size_t offset = 0; offset < frames; offset += chunk_frames)
+        {
+            size_t chunk = std::min(frames - offset, chunk_frames);
+            std::fill(sums, sums + chunk * lanes, 0.0f);
+
+            for (size_t group = 0; group < bank.m_phase.size(); group += W)
+            {
+                vint stage;
+                load(stage, &bank.m_stage[group]);
+
+                bool is_active = false;
+                for (size_t l = 0; l < W; ++l)
+                {
+                    is_active |= stage[l] != Stage::OFF;
+                }
+
+                if (!is_active)
+                {
+                    continue;
+                }
+
+                // Load the group's state into registers, and turn the
+                // frequencies and stage durations into increments per
+                // sample.
+                vfloat phase, phase_inc, vol, level, attack_inc, decay_inc, sustain, release_inc;
+                load(phase, &bank.m_phase[group]);
+                load(phase_inc, &bank.m_freq[group]);
+                load(vol, &bank.m_vol[group]);
+                load(level, &bank.m_level[group]);
+                load(attack_inc, &bank.m_attack[group]);
+                load(decay_inc, &bank.m_decay[group]);
+                load(sustain, &bank.m_sustain[group]);
+                load(release_inc, &bank.m_release[group]);
+
+                phase_inc = sample_duration * phase_inc;
+                attack_inc = sample_duration / attack_inc;
+                decay_inc = sample_duration / decay_inc;
+                release_inc = sample_duration / release_inc;
+
+                float* group_sums = sums + group % lanes;
+
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    // Envelope: add the stage's increment to the level, and
+                    // move to the next stage once it passes the stage's end,
+                    // without branches.
+                    vint is_attack = stage == attack;
+                    vint is_decay = stage == decay;
+                    vint is_release = stage == release;
+
+                    vfloat delta = is_attack ? attack_inc : zero;
+                    delta = is_decay ? -decay_inc : delta;
+                    delta = is_release ? -release_inc : delta;
+                    level += delta;
+
+                    vint attack_done = is_attack & (level >= 1);
+                    vint decay_done = is_decay & (level <= sustain);
+                    vint release_done = is_release & (level <= 0);
+
+                    level = attack_done ? one : level;
+                    level = decay_done ? sustain : level;
+                    level = (release_done | (stage == off)) ? zero : level;
+
+                    stage = attack_done ? decay : stage;
+                    stage = decay_done ? sustain_stage : stage;
+                    stage = release_done ? off : stage;
+
+                    vfloat out;
+                    shape_value<W, S>(phase, pulsewidth, out);
+                    out = vol * out * level;
+
+                    // Propagate phase.
+                    phase += phase_inc;
+                    phase = phase >= 1 ? phase - 1 : phase;
+
+                    vfloat sum;
+                    load(sum, group_sums + i * lanes);
+                    sum += out;
+                    store(group_sums + i * lanes, sum);
+                }
+
+                store(&bank.m_phase[group], phase);
+                store(&bank.m_level[group], level);
+                store(&bank.m_stage[group], stage);
+            }
+
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                vfloat_n<lanes> frame_sums;
+                load(frame_sums, sums + i * lanes);
+                output[offset + i] = sum_lanes<lanes>(frame_sums);
+            }
+        }
+    }
+};
+
+VoiceBank::VoiceBank(size_t voices, Shape shape, const EnvelopeADSR& env, float vol, bool is_retrigger)
+: m_size{voices}
+, m_shape{shape}
+, m_pulsewidth{.5}
+, m_is_retrigger{is_retrigger}
+, m_phase{}
+, m_freq{}
+, m_vol{}
+, m_level{}
+, m_stage{}
+, m_attack{}
+, m_decay{}
+, m_sustain{}
+, m_release{}
+{
+    size_t padded = (voices + lanes - 1) / lanes * lanes;
+
+    m_phase.assign(padded, 0);
+    m_freq.assign(padded, 440);
+    m_vol.assign(padded, vol);
+    m_level.assign(padded, 0);
+    m_stage.assign(padded, Stage::OFF);
+    m_attack.assign(padded, env.attack());
+    m_decay.assign(padded, env.decay());
+    m_sustain.assign(padded, env.sustain());
+    m_release.assign(padded, env.release());
+}
+
+size_t VoiceBank::size() const
+{
+    return m_size;
+}
+
+VoiceBank::Shape VoiceBank::shape() const
+{
+    return m_shape;
+}
+
+void VoiceBank::shape(Shape shape)
+{
+    m_shape = shape;
+}
+
+float VoiceBank::pulsewidth() const
+{
+    return m_pulsewidth;
+}
+
+void VoiceBank::pulsewidth(float pulsewidth)
+{
+    m_pulsewidth = pulsewidth;
+}
+
+void VoiceBank::note_on(size_t voice, float freq)
+{
+    // Reset the phase unless the note was already on (to prevent clicks).
+    if (!is_on(voice))
+    {
+        m_phase[voice] = 0;
+    }
+
+    m_freq[voice] = freq;
+    m_stage[voice] = Stage::ATTACK;
+
+    if (m_is_retrigger)
+    {
+        m_level[voice] = 0;
+    }
+}
+
+void VoiceBank::note_off(size_t voice)
+{
+    if (m_stage[voice] != Stage::OFF)
+    {
+        m_stage[voice] = Stage::RELEASE;
+    }
+}
+
+bool VoiceBank::is_on(size_t voice) const
+{
+    return m_stage[voice] != Stage::OFF;
+}
+
+float VoiceBank::freq(size_t voice) const
+{
+    return m_freq[voice];
+}
+
+void VoiceBank::freq(size_t voice, float freq)
+{
+    m_freq[voice] = freq;
+}
+
+float VoiceBank::vol(size_t voice) const
+{
+    return m_vol[voice];
+}
+
+void VoiceBank::vol(size_t voice, float vol)
+{
+    m_vol[voice] = vol;
+}
+
+void VoiceBank::env(size_t voice, const EnvelopeADSR& env)
+{
+    m_attack[voice] = env.attack();
+    m_decay[voice] = env.decay();
+    m_sustain[voice] = env.sustain();
+    m_release[voice] = env.release();
+}
+
+void VoiceBank::attack(size_t voice, float attack)
+{
+    m_attack[voice] = attack;
+}
+
+void VoiceBank::decay(size_t voice, float decay)
+{
+    m_decay[voice] = decay;
+}
+
+void VoiceBank::sustain(size_t voice, float sustain)
+{
+    m_sustain[voice] = sustain;
+}
+
+void VoiceBank::release(size_t voice, float release)
+{
+    m_release[voice] = release;
+}
+
+void VoiceBank::process(float sample_duration, float& output)
+{
+    process_block(sample_duration, &output, 1);
+}
+
+void VoiceBank::process_block(float sample_duration, float* output, size_t frames)
+{
+    switch (m_shape)
+    {
+    case Shape::Saw:
+        render<Shape::Saw>(sample_duration, output, frames);
+        return;
+
+    case Shape::Square:
+        render<Shape::Square>(sample_duration, output, frames);
+        return;
+
+    case Shape::Triangle:
+        render<Shape::Triangle>(sample_duration, output, frames);
+        return;
+
+    case Shape::Pulse:
+        render<Shape::Pulse>(sample_duration, output, frames);
+        return;
+    }
+}
+
+template <VoiceBank::Shape S>
+void VoiceBank::render(float sample_duration, float* output, size_t frames)
+{
+#ifdef MUSICLIB_VOICE_BANK_X86
+    if (has_avx512)
+    {
+        VoiceBankKernels::render_avx512<S>(*this, sample_duration, output, frames);
+        return;
+    }
+
+    if (has_avx2)
+    {
+        VoiceBankKernels::render_avx2<S>(*this, sample_duration, output, frames);
+        return;
+    }
+#endif
+
+    VoiceBankKernels::render_default<S>(*this, sample_duration, output, frames);
+}
+
+}
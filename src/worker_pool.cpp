@@ -0,0 +1,234 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace MusicLib {
+
+// A worker's state holds the generation of the last batch it took part in,
+// shifted left by two bits, and one of these statuses.
+enum WorkerStatus : uint64_t
+{
+    Running = 1,
+    Done = 2,
+    Cancelled = 3
+};
+
+static uint64_t make_state(uint64_t generation, WorkerStatus status)
+{
+    return generation << 2 | status;
+}
+
+static void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+WorkerPool::WorkerPool(unsigned int threads, bool pin)
+: m_threads{threads}
+, m_pin{pin}
+, m_workers{std::make_unique<Worker[]>(threads)}
+, m_thread_handles{}
+, m_stop{false}
+, m_generation{0}
+, m_job{nullptr}
+, m_context{nullptr}
+, m_count{0}
+, m_denormal_mode{DenormalMode::Keep}
+, m_is_realtime{false}
+, m_next{0}
+{
+    unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+
+    m_thread_handles.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        // Leave the first core to the audio thread.
+        m_thread_handles.emplace_back(&WorkerPool::work, this, std::ref(m_workers[i]), (i + 1) % cpus);
+    }
+}
+
+WorkerPool::~WorkerPool() noexcept
+{
+    m_stop = true;
+
+    // Wake the sleeping workers.
+    for (unsigned int i = 0; i < m_threads; ++i)
+    {
+        m_workers[i].go.store(m_generation + 1);
+        m_workers[i].go.notify_one();
+    }
+
+    for (auto& t : m_thread_handles)
+    {
+        t.join();
+    }
+}
+
+unsigned int WorkerPool::threads() const
+{
+    return m_threads;
+}
+
+bool WorkerPool::pinned() const
+{
+    return m_pin;
+}
+
+void WorkerPool::run(void (*job)(void*, size_t), void* context, size_t count)
+{
+    // The previous batch is over: every worker is either done or was
+    // cancelled, so the job can be replaced safely.
+    ++m_generation;
+    m_job = job;
+    m_context = context;
+    m_count = count;
+    m_denormal_mode = DenormalGuard::current();
+    m_is_realtime = RealtimeCheck::is_realtime();
+    m_next.store(0, std::memory_order_relaxed);
+
+    for (unsigned int i = 0; i < m_threads; ++i)
+    {
+        // Sequentially consistent, so that either the worker sees the new
+        // generation before going to sleep, or it's seen sleeping here.
+        m_workers[i].go.store(m_generation);
+
+        if (m_workers[i].sleeping.load())
+        {
+            m_workers[i].go.notify_one();
+        }
+    }
+
+    claim_jobs();
+
+    // Every job has been claimed. Cancel the workers that haven't started,
+    // and wait only for those that are still running a job.
+    for (unsigned int i = 0; i < m_threads; ++i)
+    {
+        auto& state = m_workers[i].state;
+        uint64_t s = state.load(std::memory_order_acquire);
+
+        if ((s >> 2) < m_generation
+            && state.compare_exchange_strong(s, make_state(m_generation, Cancelled), std::memory_order_acq_rel))
+        {
+            continue;
+        }
+
+        while (state.load(std::memory_order_acquire) != make_state(m_generation, Done))
+        {
+            cpu_relax();
+        }
+    }
+}
+
+void WorkerPool::claim_jobs()
+{
+    size_t index;
+
+    while ((index = m_next.fetch_add(1, std::memory_order_relaxed)) < m_count)
+    {
+        m_job(m_context, index);
+    }
+}
+
+void WorkerPool::work(Worker& worker, unsigned int cpu [[maybe_unused]])
+{
+#ifdef __linux__
+    if (m_pin)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+#endif
+
+    // Spin this many times before starting to yield the core while idle, and
+    // yield for this long before sleeping. Longer than the period of any
+    // audio callback, so workers only sleep while no batches are coming.
+    constexpr unsigned int spin_count = 1 << 14;
+    constexpr auto yield_duration = std::chrono::milliseconds{200};
+    uint64_t seen = 0;
+    DenormalMode denormal_mode = DenormalMode::Keep;
+
+    while (true)
+    {
+        uint64_t generation;
+        unsigned int spins = 0;
+        std::chrono::steady_clock::time_point yield_start;
+
+        while ((generation = worker.go.load(std::memory_order_acquire)) == seen)
+        {
+            if (spins < spin_count)
+            {
+                ++spins;
+                cpu_relax();
+            }
+            else if (spins == spin_count)
+            {
+                ++spins;
+                yield_start = std::chrono::steady_clock::now();
+            }
+            else if (std::chrono::steady_clock::now() - yield_start < yield_duration)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                worker.sleeping.store(true);
+
+                if (worker.go.load() == seen)
+                {
+                    worker.go.wait(seen);
+                }
+
+                worker.sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        if (m_stop.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        seen = generation;
+
+        // Check in, unless the calling thread has already finished the batch
+        // and cancelled this worker.
+        uint64_t s = worker.state.load(std::memory_order_acquire);
+        if ((s >> 2) >= generation
+            || !worker.state.compare_exchange_strong(s, make_state(generation, Running), std::memory_order_acq_rel))
+        {
+            continue;
+        }
+
+        // Writing the control register stalls the pipeline, so the mode is
+        // only set when the calling thread's changes.
+        if (m_denormal_mode != denormal_mode)
+        {
+            DenormalGuard::set_thread_mode(m_denormal_mode);
+            denormal_mode = m_denormal_mode;
+        }
+
+        {
+            RealtimeCheck::Scope realtime_scope{m_is_realtime};
+            claim_jobs();
+        }
+
+        worker.state.store(make_state(generation, Done), std::memory_order_release);
+    }
+}
+
+}